@@ -0,0 +1,154 @@
+#include "transport_catalogue.h"
+#include "geo.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Micro-benchmark of a Bus request on a large route: the road and geo lengths of one
+// non-roundtrip bus summed through the id accessors of the catalogue, and through a
+// lookup which copies a stop with its road distances for every path segment, like the
+// by-value GetStopData the id accessors replaced.
+// Usage: bus_stats_benchmark [iterations]
+
+using namespace std;
+using namespace transport;
+
+namespace {
+
+constexpr size_t STOP_COUNT = 400;
+constexpr size_t DISTANCES_PER_STOP = 30;
+constexpr size_t PATH_SIZE = 4000;
+
+// A stop as it was stored before the id accessors: coordinates with the distances to other stops
+struct CopiedStopData {
+	geo::Coordinates coordinates;
+	unordered_map<string, size_t> distances;
+};
+
+class CopyingCatalogue {
+public:
+	void AddStop(string_view stop_name, CopiedStopData&& stop) {
+		stops_.emplace(stop_name, move(stop));
+	}
+
+	pair<CopiedStopData, bool> GetStopData(string_view stop_name) const {
+		if (auto it = stops_.find(stop_name); it != stops_.end()) {
+			return { it->second, true };
+		}
+		return { CopiedStopData{}, false };
+	}
+
+	size_t GetDistance(string_view stop_from, string_view stop_to) const {
+		const CopiedStopData stop = GetStopData(stop_from).first;
+		if (auto it = stop.distances.find(string(stop_to)); it != stop.distances.end()) {
+			return it->second;
+		}
+		return GetStopData(stop_to).first.distances.at(string(stop_from));
+	}
+
+private:
+	unordered_map<string_view, CopiedStopData> stops_;
+};
+
+struct Network {
+	TransportCatalogue transport;
+	CopyingCatalogue copying_transport;
+	vector<string> stop_names;
+	vector<StopId> path;
+};
+
+void BuildNetwork(Network& network) {
+	mt19937 generator(42);
+	uniform_real_distribution<double> coordinate(55.5, 55.9);
+	uniform_int_distribution<StopId> stop_id(0, STOP_COUNT - 1);
+	uniform_int_distribution<size_t> distance(100, 5000);
+
+	vector<CopiedStopData> copied_stops(STOP_COUNT);
+	for (StopId stop = 0; stop < STOP_COUNT; ++stop) {
+		network.stop_names.push_back("Stop "s + to_string(stop));
+		copied_stops[stop].coordinates = { coordinate(generator), coordinate(generator) };
+		network.transport.AddStop(network.stop_names[stop], StopData(copied_stops[stop].coordinates));
+	}
+
+	vector<vector<StopId>> neighbours(STOP_COUNT);
+	for (StopId stop = 0; stop < STOP_COUNT; ++stop) {
+		for (size_t index = 0; index < DISTANCES_PER_STOP; ++index) {
+			const StopId other_stop = stop_id(generator);
+			if (other_stop == stop) {
+				continue;
+			}
+			const size_t meters = distance(generator);
+			network.transport.SetDistance(stop, other_stop, meters);
+			copied_stops[stop].distances[network.stop_names[other_stop]] = meters;
+			neighbours[stop].push_back(other_stop);
+		}
+	}
+
+	// A random walk along the road distances, so every segment has one in either direction
+	network.path.push_back(0);
+	while (network.path.size() < PATH_SIZE) {
+		const vector<StopId>& next_stops = neighbours[network.path.back()];
+		network.path.push_back(next_stops[uniform_int_distribution<size_t>(0, next_stops.size() - 1)(generator)]);
+	}
+	network.transport.AddBus("Bus"s, vector<StopId>(network.path), false);
+
+	for (StopId stop = 0; stop < STOP_COUNT; ++stop) {
+		network.copying_transport.AddStop(network.stop_names[stop], move(copied_stops[stop]));
+	}
+}
+
+size_t ComputeCopyingRouteLength(const Network& network) {
+	const CopyingCatalogue& transport = network.copying_transport;
+	double geo_length = 0.;
+	size_t route_length = 0;
+
+	for (size_t index = 0; index + 1 < network.path.size(); ++index) {
+		const string_view stop_from = network.stop_names[network.path[index]];
+		const string_view stop_to = network.stop_names[network.path[index + 1]];
+		geo_length += geo::ComputeDistance(transport.GetStopData(stop_from).first.coordinates,
+			transport.GetStopData(stop_to).first.coordinates);
+		route_length += transport.GetDistance(stop_from, stop_to) + transport.GetDistance(stop_to, stop_from);
+	}
+	return route_length + static_cast<size_t>(geo_length > 0.);
+}
+
+template <typename Function>
+void Measure(string_view name, size_t iterations, Function function) {
+	size_t result = 0;
+	const auto start = chrono::steady_clock::now();
+	for (size_t iteration = 0; iteration < iterations; ++iteration) {
+		result += function();
+	}
+	const chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+	cout << name << ": "sv << elapsed.count() / iterations << " ms per Bus request (checksum "sv << result / iterations << ")\n"sv;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+
+	const size_t iterations = argc > 1 ? static_cast<size_t>(atol(argv[1])) : 20;
+	if (iterations == 0) {
+		cerr << "Usage: bus_stats_benchmark [iterations]\n"sv;
+		return 1;
+	}
+
+	Network network;
+	BuildNetwork(network);
+	const BusId bus_id = *network.transport.FindBusId("Bus"sv);
+
+	Measure("id accessors"sv, iterations, [&network, bus_id] {
+		const BusStats stats = network.transport.ComputeBusStats(bus_id);
+		return stats.route_length + static_cast<size_t>(stats.geo_length > 0.);
+	});
+	Measure("copying lookups"sv, iterations, [&network] {
+		return ComputeCopyingRouteLength(network);
+	});
+}
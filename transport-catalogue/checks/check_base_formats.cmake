@@ -0,0 +1,59 @@
+# Makes a base of make_base.json in every file format and compression, for each router mode
+# of ROUTER_MODES, and checks that each answers stat_requests.json, which holds requests of
+# every type, exactly as the uncompressed protobuf base. ROUTER_MODES separates the modes with commas.
+# Usage: cmake -DTRANSPORT_CATALOGUE=<executable> -DDATA_DIR=<dir> -DWORK_DIR=<dir>
+#              -DROUTER_MODES=<router_mode>,... -P check_base_formats.cmake
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+file(READ ${DATA_DIR}/make_base.json make_base)
+file(READ ${DATA_DIR}/stat_requests.json stat_requests)
+
+function(run_mode mode input output)
+	execute_process(COMMAND ${TRANSPORT_CATALOGUE} ${mode}
+					INPUT_FILE ${WORK_DIR}/${input}
+					OUTPUT_FILE ${WORK_DIR}/${output}
+					WORKING_DIRECTORY ${WORK_DIR}
+					RESULT_VARIABLE result)
+	if(NOT result EQUAL 0)
+		message(FATAL_ERROR "${mode} < ${input} failed: ${result}")
+	endif()
+endfunction()
+
+# Answers the requests from a base of its own in the format, to <router_mode>.<format>.<compression>.json
+function(process_with router_mode format compression output_name)
+	set(name ${router_mode}.${format}.${compression})
+
+	string(REPLACE "\"routing_settings\": {" "\"routing_settings\": {\n\t\t\"router_mode\": \"${router_mode}\","
+				   input "${make_base}")
+	string(REPLACE "\"file\": \"base.bin\""
+				   "\"file\": \"${name}.bin\",\n\t\t\"format\": \"${format}\",\n\t\t\"compression\": \"${compression}\""
+				   input "${input}")
+	file(WRITE ${WORK_DIR}/${name}.make_base.json "${input}")
+
+	string(REPLACE "\"base.bin\"" "\"${name}.bin\"" input "${stat_requests}")
+	file(WRITE ${WORK_DIR}/${name}.process_requests.json "${input}")
+
+	run_mode(make_base ${name}.make_base.json ${name}.make_base.out)
+	run_mode(process_requests ${name}.process_requests.json ${name}.json)
+	set(${output_name} ${name}.json PARENT_SCOPE)
+endfunction()
+
+string(REPLACE "," ";" router_modes ${ROUTER_MODES})
+
+foreach(router_mode ${router_modes})
+	process_with(${router_mode} protobuf none reference)
+
+	foreach(format_compression protobuf/zlib mapped/none)
+		string(REPLACE "/" ";" parts ${format_compression})
+		list(GET parts 0 format)
+		list(GET parts 1 compression)
+		process_with(${router_mode} ${format} ${compression} output)
+
+		execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${WORK_DIR}/${output} ${WORK_DIR}/${reference}
+						RESULT_VARIABLE result)
+		if(NOT result EQUAL 0)
+			message(FATAL_ERROR "The ${format} base with ${compression} compression answers differently from "
+								"the uncompressed protobuf base: compare ${WORK_DIR}/${output} with ${WORK_DIR}/${reference}")
+		endif()
+	endforeach()
+endforeach()
@@ -0,0 +1,70 @@
+# Makes a base of make_base.json in every file format and compression and checks that
+# process_requests answers stat_requests.json from it, but fails with an error on a copy
+# of it without its last byte, with its last byte flipped, which lies in a checked section
+# or block, or with a flipped byte in a checksum of its header.
+# Usage: cmake -DTRANSPORT_CATALOGUE=<executable> -DDAMAGE_FILE=<executable> -DDATA_DIR=<dir>
+#              -DWORK_DIR=<dir> -P check_damaged_base.cmake
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+file(READ ${DATA_DIR}/make_base.json make_base)
+file(READ ${DATA_DIR}/stat_requests.json stat_requests)
+
+# Runs the mode with the input and gives its exit code
+function(run_mode mode input output result_name)
+	execute_process(COMMAND ${TRANSPORT_CATALOGUE} ${mode}
+					INPUT_FILE ${WORK_DIR}/${input}
+					OUTPUT_FILE ${WORK_DIR}/${output}
+					ERROR_FILE ${WORK_DIR}/${output}.err
+					WORKING_DIRECTORY ${WORK_DIR}
+					RESULT_VARIABLE result)
+	set(${result_name} ${result} PARENT_SCOPE)
+endfunction()
+
+# Answers the requests from the base file, to <base>.json
+function(process_base base result_name)
+	string(REPLACE "\"base.bin\"" "\"${base}\"" input "${stat_requests}")
+	file(WRITE ${WORK_DIR}/${base}.process_requests.json "${input}")
+	run_mode(process_requests ${base}.process_requests.json ${base}.json result)
+	set(${result_name} ${result} PARENT_SCOPE)
+endfunction()
+
+# <format>/<compression>/<offset of a section checksum in the file header>: the catalogue
+# section of a protobuf base, the names section of a mapped base
+foreach(format_compression protobuf/none/24 protobuf/zlib/24 mapped/none/80)
+	string(REPLACE "/" ";" parts ${format_compression})
+	list(GET parts 0 format)
+	list(GET parts 1 compression)
+	list(GET parts 2 checksum_offset)
+	set(base ${format}.${compression}.bin)
+
+	string(REPLACE "\"file\": \"base.bin\""
+				   "\"file\": \"${base}\",\n\t\t\"format\": \"${format}\",\n\t\t\"compression\": \"${compression}\""
+				   input "${make_base}")
+	file(WRITE ${WORK_DIR}/${base}.make_base.json "${input}")
+	run_mode(make_base ${base}.make_base.json ${base}.make_base.out result)
+	if(NOT result EQUAL 0)
+		message(FATAL_ERROR "make_base < ${base}.make_base.json failed: ${result}")
+	endif()
+
+	process_base(${base} result)
+	if(NOT result EQUAL 0)
+		message(FATAL_ERROR "process_requests rejects the intact ${base}: ${result}")
+	endif()
+
+	foreach(damage "truncate 1" "flip -1" "flip ${checksum_offset}")
+		separate_arguments(damage_arguments UNIX_COMMAND "${damage}")
+		string(REPLACE " " "" damaged_base "${damage}.${base}")
+		execute_process(COMMAND ${DAMAGE_FILE} ${WORK_DIR}/${base} ${WORK_DIR}/${damaged_base} ${damage_arguments}
+						RESULT_VARIABLE result)
+		if(NOT result EQUAL 0)
+			message(FATAL_ERROR "damage_file ${damage} of ${base} failed: ${result}")
+		endif()
+
+		# Exit code 1 is a reported error; a crash gives another code or a message
+		process_base(${damaged_base} result)
+		if(NOT result EQUAL 1)
+			message(FATAL_ERROR "process_requests < ${damaged_base}.process_requests.json does not fail with an error: "
+								"${result}, see ${WORK_DIR}/${damaged_base}.json")
+		endif()
+	endforeach()
+endforeach()
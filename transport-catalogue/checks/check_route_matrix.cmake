@@ -0,0 +1,93 @@
+# Makes a base of make_base.json in every router mode of ROUTER_MODES and checks that the
+# RouteMatrix request of route_matrix.json, between every stop and an unknown one,
+# answers each cell exactly as the Route request of process_requests.json for the same pair.
+# ROUTER_MODES separates the modes with commas. Needs CMake 3.19 for string(JSON).
+# Usage: cmake -DTRANSPORT_CATALOGUE=<executable> -DDATA_DIR=<dir> -DWORK_DIR=<dir>
+#              -DROUTER_MODES=<router_mode>,... -P check_route_matrix.cmake
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+file(READ ${DATA_DIR}/make_base.json make_base)
+file(READ ${DATA_DIR}/process_requests.json process_requests)
+file(READ ${DATA_DIR}/route_matrix.json route_matrix)
+
+function(run_mode mode input output)
+	execute_process(COMMAND ${TRANSPORT_CATALOGUE} ${mode}
+					INPUT_FILE ${WORK_DIR}/${input}
+					OUTPUT_FILE ${WORK_DIR}/${output}
+					WORKING_DIRECTORY ${WORK_DIR}
+					RESULT_VARIABLE result)
+	if(NOT result EQUAL 0)
+		message(FATAL_ERROR "${mode} < ${input} failed: ${result}")
+	endif()
+endfunction()
+
+# Writes the requests with the base file of the router mode and answers them, to <router_mode>.<name>.json
+function(process_requests_with router_mode name requests)
+	string(REPLACE "\"base.bin\"" "\"${router_mode}.bin\"" input "${requests}")
+	file(WRITE ${WORK_DIR}/${router_mode}.${name}.input.json "${input}")
+	run_mode(process_requests ${router_mode}.${name}.input.json ${router_mode}.${name}.json)
+endfunction()
+
+# The element at the path of keys and indices; null for a JSON null, which GET gives as an empty string
+function(get_json_value output json)
+	string(JSON type TYPE "${json}" ${ARGN})
+	if(type STREQUAL "NULL")
+		set(${output} null PARENT_SCOPE)
+	else()
+		string(JSON value GET "${json}" ${ARGN})
+		set(${output} "${value}" PARENT_SCOPE)
+	endif()
+endfunction()
+
+string(JSON from_count LENGTH "${route_matrix}" stat_requests 0 from)
+string(JSON to_count LENGTH "${route_matrix}" stat_requests 0 to)
+string(REPLACE "," ";" router_modes ${ROUTER_MODES})
+
+foreach(router_mode ${router_modes})
+	string(REPLACE "\"routing_settings\": {" "\"routing_settings\": {\n\t\t\"router_mode\": \"${router_mode}\","
+				   input "${make_base}")
+	string(REPLACE "\"base.bin\"" "\"${router_mode}.bin\"" input "${input}")
+	file(WRITE ${WORK_DIR}/${router_mode}.make_base.json "${input}")
+	run_mode(make_base ${router_mode}.make_base.json ${router_mode}.make_base.out)
+
+	process_requests_with(${router_mode} routes "${process_requests}")
+	process_requests_with(${router_mode} matrix "${route_matrix}")
+	file(READ ${WORK_DIR}/${router_mode}.routes.json routes)
+	file(READ ${WORK_DIR}/${router_mode}.matrix.json matrix)
+
+	# The answers to the Route requests come in the order of the requests; they are kept by stop pair
+	string(JSON route_count LENGTH "${routes}")
+	math(EXPR last_route "${route_count} - 1")
+	foreach(route_index RANGE ${last_route})
+		string(JSON route_from GET "${process_requests}" stat_requests ${route_index} from)
+		string(JSON route_to GET "${process_requests}" stat_requests ${route_index} to)
+		string(JSON route_${route_from}_${route_to} GET "${routes}" ${route_index})
+	endforeach()
+
+	math(EXPR last_from "${from_count} - 1")
+	math(EXPR last_to "${to_count} - 1")
+	foreach(from_index RANGE ${last_from})
+		string(JSON from GET "${route_matrix}" stat_requests 0 from ${from_index})
+		foreach(to_index RANGE ${last_to})
+			string(JSON to GET "${route_matrix}" stat_requests 0 to ${to_index})
+			get_json_value(total_time "${matrix}" 0 total_times ${from_index} ${to_index})
+			get_json_value(itinerary "${matrix}" 0 itineraries ${from_index} ${to_index})
+
+			if(NOT DEFINED route_${from}_${to})
+				message(FATAL_ERROR "process_requests.json has no Route request from ${from} to ${to}")
+			endif()
+			string(JSON expected_total_time ERROR_VARIABLE no_route GET "${route_${from}_${to}}" total_time)
+
+			if(no_route)
+				set(expected_total_time null)
+				set(expected_itinerary null)
+			else()
+				string(JSON expected_itinerary GET "${route_${from}_${to}}" items)
+			endif()
+			if(NOT total_time STREQUAL expected_total_time OR NOT itinerary STREQUAL expected_itinerary)
+				message(FATAL_ERROR "RouteMatrix of the ${router_mode} base answers ${from} -> ${to} with "
+									"${total_time} ${itinerary} instead of ${expected_total_time} ${expected_itinerary}")
+			endif()
+		endforeach()
+	endforeach()
+endforeach()
@@ -0,0 +1,55 @@
+# Makes a base of make_base.json with every routing configuration of CONFIGS and checks that
+# each answers process_requests.json exactly as the base made with the REFERENCE configuration.
+# A configuration is <graph_model>/<router_mode>; CONFIGS separates them with commas.
+# Usage: cmake -DTRANSPORT_CATALOGUE=<executable> -DDATA_DIR=<dir> -DWORK_DIR=<dir>
+#              -DREFERENCE=<configuration> -DCONFIGS=<configuration>,... -P check_routing_configs.cmake
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+file(READ ${DATA_DIR}/make_base.json make_base)
+file(READ ${DATA_DIR}/process_requests.json process_requests)
+
+function(run_mode mode input output)
+	execute_process(COMMAND ${TRANSPORT_CATALOGUE} ${mode}
+					INPUT_FILE ${WORK_DIR}/${input}
+					OUTPUT_FILE ${WORK_DIR}/${output}
+					WORKING_DIRECTORY ${WORK_DIR}
+					RESULT_VARIABLE result)
+	if(NOT result EQUAL 0)
+		message(FATAL_ERROR "${mode} < ${input} failed: ${result}")
+	endif()
+endfunction()
+
+# Answers the requests from a base of its own made with the configuration, to <graph_model>.<router_mode>.json
+function(process_with configuration output_name)
+	string(REPLACE "/" ";" parts ${configuration})
+	list(GET parts 0 graph_model)
+	list(GET parts 1 router_mode)
+	set(name ${graph_model}.${router_mode})
+
+	string(REPLACE "\"routing_settings\": {"
+				   "\"routing_settings\": {\n\t\t\"graph_model\": \"${graph_model}\",\n\t\t\"router_mode\": \"${router_mode}\","
+				   input "${make_base}")
+	string(REPLACE "\"base.bin\"" "\"${name}.bin\"" input "${input}")
+	file(WRITE ${WORK_DIR}/${name}.make_base.json "${input}")
+
+	string(REPLACE "\"base.bin\"" "\"${name}.bin\"" input "${process_requests}")
+	file(WRITE ${WORK_DIR}/${name}.process_requests.json "${input}")
+
+	run_mode(make_base ${name}.make_base.json ${name}.make_base.out)
+	run_mode(process_requests ${name}.process_requests.json ${name}.json)
+	set(${output_name} ${name}.json PARENT_SCOPE)
+endfunction()
+
+process_with(${REFERENCE} reference)
+string(REPLACE "," ";" configurations ${CONFIGS})
+
+foreach(configuration ${configurations})
+	process_with(${configuration} output)
+
+	execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${WORK_DIR}/${output} ${WORK_DIR}/${reference}
+					RESULT_VARIABLE result)
+	if(NOT result EQUAL 0)
+		message(FATAL_ERROR "The ${configuration} base answers differently from the ${REFERENCE} base: "
+							"compare ${WORK_DIR}/${output} with ${WORK_DIR}/${reference}")
+	endif()
+endforeach()
@@ -0,0 +1,29 @@
+# Applies update_base.json to the base of make_base.json and checks that the updated base
+# answers process_requests exactly as a base made from scratch from make_base_final.json.
+# Usage: cmake -DTRANSPORT_CATALOGUE=<executable> -DDATA_DIR=<dir> -DWORK_DIR=<dir> -P check_update_base.cmake
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+function(run_mode mode input output)
+	execute_process(COMMAND ${TRANSPORT_CATALOGUE} ${mode}
+					INPUT_FILE ${DATA_DIR}/${input}
+					OUTPUT_FILE ${WORK_DIR}/${output}
+					WORKING_DIRECTORY ${WORK_DIR}
+					RESULT_VARIABLE result)
+	if(NOT result EQUAL 0)
+		message(FATAL_ERROR "${mode} < ${input} failed: ${result}")
+	endif()
+endfunction()
+
+run_mode(make_base make_base.json make_base.out)
+run_mode(update_base update_base.json update_base.out)
+run_mode(make_base make_base_final.json make_base_final.out)
+run_mode(process_requests process_requests_updated.json updated.json)
+run_mode(process_requests process_requests_final.json final.json)
+
+execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${WORK_DIR}/updated.json ${WORK_DIR}/final.json
+				RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+	message(FATAL_ERROR "The updated base answers differently from the base made from scratch: "
+						"compare ${WORK_DIR}/updated.json with ${WORK_DIR}/final.json")
+endif()
@@ -0,0 +1,45 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+// Writes a damaged copy of a file for the base checks: without its last byte_count bytes,
+// or with the bits of the byte at offset inverted; a negative offset counts from the end.
+// Usage: damage_file <input> <output> truncate <byte_count>
+//        damage_file <input> <output> flip <offset>
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+
+	if (argc != 5) {
+		cerr << "Usage: damage_file <input> <output> truncate|flip <count>\n"sv;
+		return 1;
+	}
+	ifstream input{ argv[1], ios::binary };
+	vector<char> data{ istreambuf_iterator<char>(input), istreambuf_iterator<char>() };
+	const string_view action(argv[3]);
+	const long long count = atoll(argv[4]);
+	const long long size = static_cast<long long>(data.size());
+
+	if (!input) {
+		cerr << "Cannot read "sv << argv[1] << '\n';
+		return 1;
+	}
+	if (action == "truncate"sv && count >= 0 && count <= size) {
+		data.resize(static_cast<size_t>(size - count));
+	}
+	else if (action == "flip"sv && count >= -size && count < size) {
+		char& byte = data[static_cast<size_t>(count < 0 ? size + count : count)];
+		byte = static_cast<char>(~byte);
+	}
+	else {
+		cerr << "Cannot "sv << action << ' ' << count << " in "sv << argv[1] << '\n';
+		return 1;
+	}
+	ofstream output{ argv[2], ios::binary };
+	output.write(data.data(), static_cast<streamsize>(data.size()));
+	return output ? 0 : 1;
+}
@@ -0,0 +1,136 @@
+#include "checksum.h"
+#include "parallel.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+constexpr uint64_t PRIME_1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t PRIME_3 = 0x165667B19E3779F9ull;
+constexpr uint64_t PRIME_4 = 0x85EBCA77C2B2AE63ull;
+constexpr uint64_t PRIME_5 = 0x27D4EB2F165667C5ull;
+
+uint64_t RotateLeft(uint64_t value, int bits) {
+	return (value << bits) | (value >> (64 - bits));
+}
+
+// Little-endian whatever the platform, so a file has the same checksums everywhere
+uint64_t Load64(const uint8_t* data) {
+	uint64_t value = 0;
+	for (int index = 7; index >= 0; --index) {
+		value = (value << 8) | data[index];
+	}
+	return value;
+}
+
+uint64_t Load32(const uint8_t* data) {
+	return uint64_t{ data[0] } | uint64_t{ data[1] } << 8 | uint64_t{ data[2] } << 16 | uint64_t{ data[3] } << 24;
+}
+
+uint64_t Round(uint64_t accumulator, uint64_t input) {
+	return RotateLeft(accumulator + input * PRIME_2, 31) * PRIME_1;
+}
+
+uint64_t MergeRound(uint64_t accumulator, uint64_t value) {
+	return (accumulator ^ Round(0, value)) * PRIME_1 + PRIME_4;
+}
+
+} // namespace
+
+uint64_t ComputeChecksum(const void* data, size_t size) {
+
+	const uint8_t* position = static_cast<const uint8_t*>(data);
+	const uint8_t* const end = position + size;
+	uint64_t hash;
+
+	if (size >= 32) {
+
+		uint64_t lanes[4] = { PRIME_1 + PRIME_2, PRIME_2, 0, 0 - PRIME_1 };
+
+		for (; end - position >= 32; position += 32) {
+			for (int lane = 0; lane < 4; ++lane) {
+				lanes[lane] = Round(lanes[lane], Load64(position + lane * 8));
+			}
+		}
+		hash = RotateLeft(lanes[0], 1) + RotateLeft(lanes[1], 7) + RotateLeft(lanes[2], 12) + RotateLeft(lanes[3], 18);
+
+		for (uint64_t lane : lanes) {
+			hash = MergeRound(hash, lane);
+		}
+	}
+	else {
+		hash = PRIME_5;
+	}
+	hash += size;
+
+	for (; end - position >= 8; position += 8) {
+		hash = RotateLeft(hash ^ Round(0, Load64(position)), 27) * PRIME_1 + PRIME_4;
+	}
+	if (end - position >= 4) {
+		hash = RotateLeft(hash ^ Load32(position) * PRIME_1, 23) * PRIME_2 + PRIME_3;
+		position += 4;
+	}
+	for (; position != end; ++position) {
+		hash = RotateLeft(hash ^ *position * PRIME_5, 11) * PRIME_1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= PRIME_2;
+	hash ^= hash >> 29;
+	hash *= PRIME_3;
+	return hash ^ (hash >> 32);
+}
+
+uint64_t CombineChecksums(const vector<uint64_t>& checksums) {
+
+	vector<uint8_t> bytes(checksums.size() * 8);
+
+	for (size_t index = 0; index < checksums.size(); ++index) {
+		for (size_t byte = 0; byte < 8; ++byte) {
+			bytes[index * 8 + byte] = static_cast<uint8_t>(checksums[index] >> (byte * 8));
+		}
+	}
+	return ComputeChecksum(bytes.data(), bytes.size());
+}
+
+vector<uint64_t> ComputeSectionChecksums(const vector<ChecksumRange>& ranges) {
+
+	struct Chunk {
+		size_t range_index;
+		size_t offset;
+	};
+
+	vector<Chunk> chunks;
+
+	for (size_t range_index = 0; range_index < ranges.size(); ++range_index) {
+		for (size_t offset = 0; offset < ranges[range_index].size; offset += CHECKSUM_CHUNK_SIZE) {
+			chunks.push_back(Chunk{ range_index, offset });
+		}
+	}
+
+	vector<uint64_t> chunk_checksums(chunks.size());
+
+	ParallelFor(chunks.size(), [&ranges, &chunks, &chunk_checksums](size_t index) {
+		const ChecksumRange& range = ranges[chunks[index].range_index];
+		chunk_checksums[index] = ComputeChecksum(static_cast<const char*>(range.data) + chunks[index].offset,
+												 min(CHECKSUM_CHUNK_SIZE, range.size - chunks[index].offset));
+	});
+
+	vector<uint64_t> checksums;
+	checksums.reserve(ranges.size());
+
+	for (size_t chunk_begin = 0, range_index = 0; range_index < ranges.size(); ++range_index) {
+
+		size_t chunk_end = chunk_begin;
+		while (chunk_end < chunks.size() && chunks[chunk_end].range_index == range_index) {
+			++chunk_end;
+		}
+		checksums.push_back(CombineChecksums(vector<uint64_t>(chunk_checksums.begin() + chunk_begin,
+															   chunk_checksums.begin() + chunk_end)));
+		chunk_begin = chunk_end;
+	}
+	return checksums;
+}
\ No newline at end of file
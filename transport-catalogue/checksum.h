@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Checksums of base file sections. A piece of data is hashed with XXH64, a fast
+// non-cryptographic 64-bit hash; a section checksum is the hash of the sequence of
+// the hashes of its pieces, so the pieces of a large section are hashed in parallel.
+
+struct ChecksumRange {
+	const void* data = nullptr;
+	size_t size = 0;
+};
+
+uint64_t ComputeChecksum(const void* data, size_t size);
+
+uint64_t CombineChecksums(const std::vector<uint64_t>& checksums);
+
+// Section checksum of every range, with CHECKSUM_CHUNK_SIZE pieces hashed on worker threads
+std::vector<uint64_t> ComputeSectionChecksums(const std::vector<ChecksumRange>& ranges);
+
+constexpr size_t CHECKSUM_CHUNK_SIZE = 1 << 20;
\ No newline at end of file
@@ -0,0 +1,714 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "dijkstra_router.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+	// Contraction hierarchy of a graph: the contraction order of the vertices and the
+	// shortcuts added while contracting them. Edge ids below the graph edge count are the
+	// graph edges, the next ones are the shortcuts in the order they were added. A shortcut
+	// stands for two edges with smaller ids, so unpacking it always ends in graph edges.
+	template <typename Weight>
+	struct ContractionHierarchy {
+		struct Shortcut {
+			VertexId from;
+			VertexId to;
+			Weight weight;
+			EdgeId first_edge; // from -> contracted vertex
+			EdgeId second_edge; // contracted vertex -> to
+		};
+
+		std::vector<VertexId> ranks; // contraction order of every vertex, 0 - contracted first
+		std::vector<Shortcut> shortcuts;
+	};
+
+	namespace detail {
+
+		// Contracts the vertices one by one, least important first. The priority of a vertex is
+		// the number of shortcuts its contraction adds less the number of edges it removes, plus
+		// the number of its neighbours contracted before it, which spreads the contraction evenly
+		// over the graph. The queue starts from an estimate which only looks at direct edges;
+		// the priority is computed in full when a vertex comes to the top, and the vertex goes
+		// back to the queue unless it is still the least important.
+		// A shortcut u -> w is added for the contracted v only if the local search from u, which
+		// avoids v and settles at most MAX_SETTLED_VERTICES, finds no route as short as u -> v -> w.
+		// A search cut short may add a shortcut which is not needed, but never misses one.
+		template <typename Weight>
+		class HierarchyBuilder {
+		private:
+			using Graph = DirectedWeightedGraph<Weight>;
+			using Hierarchy = ContractionHierarchy<Weight>;
+			using Shortcut = typename Hierarchy::Shortcut;
+
+		public:
+			explicit HierarchyBuilder(const Graph& graph)
+				: graph_(graph)
+				, out_edges_(graph.GetVertexCount())
+				, in_edges_(graph.GetVertexCount())
+				, contracted_neighbor_counts_(graph.GetVertexCount())
+				, distances_(graph.GetVertexCount())
+				, target_weights_(graph.GetVertexCount())
+				, heap_(graph.GetVertexCount()) {
+				for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+					const auto& edge = graph.GetEdge(edge_id);
+					if (edge.weight < ZERO_WEIGHT) {
+						throw std::domain_error("Edges' weights should be non-negative");
+					}
+					if (edge.from != edge.to) {
+						AddEdge(edge.from, edge.to, edge.weight, edge_id);
+					}
+				}
+			}
+
+			Hierarchy Build() {
+				using QueueItem = std::pair<long long, VertexId>;
+
+				const size_t vertex_count = graph_.GetVertexCount();
+				std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+				std::vector<Shortcut> shortcuts;
+
+				for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+					queue.push({ ComputePriority(vertex, ESTIMATE_SETTLED_VERTICES, shortcuts), vertex });
+				}
+				hierarchy_.ranks.resize(vertex_count);
+				VertexId rank = 0;
+
+				while (!queue.empty()) {
+					const VertexId vertex = queue.top().second;
+					queue.pop();
+					const long long priority = ComputePriority(vertex, MAX_SETTLED_VERTICES, shortcuts);
+					if (!queue.empty() && priority > queue.top().first) {
+						queue.push({ priority, vertex });
+						continue;
+					}
+					hierarchy_.ranks[vertex] = rank++;
+					Contract(vertex, shortcuts);
+				}
+				return std::move(hierarchy_);
+			}
+
+		private:
+			// The lightest edge between two vertices which are not contracted yet
+			struct WorkEdge {
+				VertexId vertex; // the other end
+				Weight weight;
+				EdgeId edge_id;
+			};
+
+			void AddEdge(VertexId from, VertexId to, Weight weight, EdgeId edge_id) {
+				auto out_it = std::find_if(out_edges_[from].begin(), out_edges_[from].end(),
+					[to](const WorkEdge& edge) { return edge.vertex == to; });
+				if (out_it == out_edges_[from].end()) {
+					out_edges_[from].push_back({ to, weight, edge_id });
+					in_edges_[to].push_back({ from, weight, edge_id });
+					return;
+				}
+				if (weight < out_it->weight) {
+					*out_it = WorkEdge{ to, weight, edge_id };
+					*std::find_if(in_edges_[to].begin(), in_edges_[to].end(),
+						[from](const WorkEdge& edge) { return edge.vertex == from; }) = WorkEdge{ from, weight, edge_id };
+				}
+			}
+
+			static void RemoveEdge(std::vector<WorkEdge>& edges, VertexId vertex) {
+				auto it = std::find_if(edges.begin(), edges.end(), [vertex](const WorkEdge& edge) { return edge.vertex == vertex; });
+				*it = edges.back();
+				edges.pop_back();
+			}
+
+			long long ComputePriority(VertexId vertex, size_t settle_limit, std::vector<Shortcut>& shortcuts) {
+				shortcuts.clear();
+				FindShortcuts(vertex, settle_limit, shortcuts);
+				return static_cast<long long>(shortcuts.size() + contracted_neighbor_counts_[vertex])
+					- static_cast<long long>(in_edges_[vertex].size() + out_edges_[vertex].size());
+			}
+
+			void FindShortcuts(VertexId vertex, size_t settle_limit, std::vector<Shortcut>& shortcuts) {
+				for (const WorkEdge& in_edge : in_edges_[vertex]) {
+					targets_.clear();
+					for (const WorkEdge& out_edge : out_edges_[vertex]) {
+						if (out_edge.vertex != in_edge.vertex) {
+							target_weights_[out_edge.vertex] = in_edge.weight + out_edge.weight;
+							targets_.push_back({ in_edge.weight + out_edge.weight, out_edge.vertex });
+						}
+					}
+					if (targets_.empty()) {
+						continue;
+					}
+					std::sort(targets_.begin(), targets_.end(), std::greater<>());
+					SearchWitnesses(in_edge.vertex, vertex, settle_limit);
+
+					for (const WorkEdge& out_edge : out_edges_[vertex]) {
+						if (out_edge.vertex == in_edge.vertex) {
+							continue;
+						}
+						if (!IsWitnessed(out_edge.vertex)) {
+							shortcuts.push_back({ in_edge.vertex, out_edge.vertex, *target_weights_[out_edge.vertex],
+												  in_edge.edge_id, out_edge.edge_id });
+						}
+						target_weights_[out_edge.vertex].reset();
+					}
+					for (const VertexId reached_vertex : reached_vertices_) {
+						distances_[reached_vertex].reset();
+					}
+					reached_vertices_.clear();
+					heap_.Clear();
+				}
+			}
+
+			// A route as short as the one through the contracted vertex is found
+			bool IsWitnessed(VertexId target) const {
+				return distances_[target] && !(*target_weights_[target] < *distances_[target]);
+			}
+
+			// Dijkstra search from source around the excluded vertex. Routes longer than the heaviest
+			// target still without a witness are not followed; the search stops once every target has
+			// a witness or settle_limit vertices are settled.
+			void SearchWitnesses(VertexId source, VertexId excluded, size_t settle_limit) {
+				distances_[source] = ZERO_WEIGHT;
+				reached_vertices_.push_back(source);
+				heap_.PushOrDecrease(source, ZERO_WEIGHT);
+				size_t target_index = 0; // targets_ are by weight descending
+
+				for (size_t settled_count = 0; !heap_.Empty() && settled_count < settle_limit; ++settled_count) {
+					while (target_index < targets_.size() && IsWitnessed(targets_[target_index].second)) {
+						++target_index;
+					}
+					if (target_index == targets_.size()) {
+						break;
+					}
+					const Weight max_weight = targets_[target_index].first;
+					const VertexId vertex = heap_.PopMin();
+					const Weight vertex_weight = *distances_[vertex];
+					if (max_weight < vertex_weight) {
+						break;
+					}
+					for (const WorkEdge& edge : out_edges_[vertex]) {
+						const Weight candidate_weight = vertex_weight + edge.weight;
+						if (edge.vertex == excluded || max_weight < candidate_weight) {
+							continue;
+						}
+						std::optional<Weight>& distance = distances_[edge.vertex];
+						if (!distance) {
+							reached_vertices_.push_back(edge.vertex);
+						}
+						else if (!(candidate_weight < *distance)) {
+							continue;
+						}
+						distance = candidate_weight;
+						heap_.PushOrDecrease(edge.vertex, candidate_weight);
+					}
+				}
+			}
+
+			void Contract(VertexId vertex, const std::vector<Shortcut>& shortcuts) {
+				for (const Shortcut& shortcut : shortcuts) {
+					const EdgeId edge_id = graph_.GetEdgeCount() + hierarchy_.shortcuts.size();
+					hierarchy_.shortcuts.push_back(shortcut);
+					AddEdge(shortcut.from, shortcut.to, shortcut.weight, edge_id);
+				}
+				for (const WorkEdge& edge : in_edges_[vertex]) {
+					RemoveEdge(out_edges_[edge.vertex], vertex);
+					++contracted_neighbor_counts_[edge.vertex];
+				}
+				for (const WorkEdge& edge : out_edges_[vertex]) {
+					RemoveEdge(in_edges_[edge.vertex], vertex);
+					++contracted_neighbor_counts_[edge.vertex];
+				}
+				std::vector<WorkEdge>().swap(in_edges_[vertex]);
+				std::vector<WorkEdge>().swap(out_edges_[vertex]);
+			}
+
+			static constexpr Weight ZERO_WEIGHT{};
+			static constexpr size_t ESTIMATE_SETTLED_VERTICES = 1; // direct edges only
+			static constexpr size_t MAX_SETTLED_VERTICES = 100;
+			const Graph& graph_;
+			std::vector<std::vector<WorkEdge>> out_edges_;
+			std::vector<std::vector<WorkEdge>> in_edges_;
+			std::vector<size_t> contracted_neighbor_counts_;
+			std::vector<std::optional<Weight>> distances_; // witness search from the current source
+			std::vector<std::optional<Weight>> target_weights_; // routes through the contracted vertex
+			std::vector<VertexId> reached_vertices_;
+			std::vector<std::pair<Weight, VertexId>> targets_; // by weight descending
+			IndexedHeap<Weight> heap_;
+			Hierarchy hierarchy_;
+		};
+
+	}  // namespace detail
+
+	// Answers each query with a bidirectional Dijkstra search over a contraction hierarchy in
+	// which both directions only go to vertices contracted later, so a query settles a few
+	// hundred vertices. The shortcuts of the route found are then unpacked into
+	// graph edges. The hierarchy is either built from the graph or given, e.g. from a base.
+	template <typename Weight>
+	class ContractionRouter {
+	private:
+		using Graph = DirectedWeightedGraph<Weight>;
+
+	public:
+		using RouteInfo = typename Router<Weight>::RouteInfo;
+		using HierarchyInternalData = ContractionHierarchy<Weight>;
+
+		explicit ContractionRouter(const Graph& graph);
+
+		ContractionRouter(const Graph& graph, HierarchyInternalData&& hierarchy);
+
+		std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+		// Routes from every source to every target, a row per source: a backward search from
+		// each target leaves its weights in buckets at the vertices it settles, and a single
+		// forward search from each source meets them there. Without with_edges the routes
+		// are not unpacked: they hold no edges and their weights are summed over shortcuts.
+		std::vector<std::vector<std::optional<RouteInfo>>> BuildRoutes(const std::vector<VertexId>& sources,
+			const std::vector<VertexId>& targets, bool with_edges) const;
+
+		const HierarchyInternalData& GetHierarchyInternalData() const;
+
+	private:
+		struct SearchEdge {
+			VertexId vertex; // the end contracted later
+			Weight weight;
+			EdgeId edge_id;
+		};
+
+		// Edges of one search direction grouped by the vertex they are walked from,
+		// the lightest one for every pair of vertices
+		struct SearchGraph {
+			std::vector<size_t> offsets; // vertex_count + 1
+			std::vector<SearchEdge> edges;
+		};
+
+		struct SearchSpace {
+			explicit SearchSpace(size_t vertex_count)
+				: weights(vertex_count)
+				, prev_edges(vertex_count, NO_EDGE)
+				, heap(vertex_count) {
+			}
+
+			// Empties the space in time linear in the vertices the search reached
+			void Reset() {
+				for (const VertexId vertex : reached_vertices) {
+					weights[vertex].reset();
+					prev_edges[vertex] = NO_EDGE;
+				}
+				reached_vertices.clear();
+				heap.Clear();
+			}
+
+			std::vector<std::optional<Weight>> weights;
+			std::vector<EdgeId> prev_edges;
+			IndexedHeap<Weight> heap;
+			std::vector<VertexId> reached_vertices; // with a weight
+		};
+
+		// Resets a search space on every exit from the query that fills it, an exception included,
+		// so that a failed query does not leave its weights to the next one on the thread
+		class SearchSpaceReset {
+		public:
+			explicit SearchSpaceReset(SearchSpace& space)
+				: space_(space) {
+			}
+
+			~SearchSpaceReset() {
+				space_.Reset();
+			}
+
+			SearchSpaceReset(const SearchSpaceReset&) = delete;
+			SearchSpaceReset& operator=(const SearchSpaceReset&) = delete;
+
+		private:
+			SearchSpace& space_;
+		};
+
+		// Search spaces of the calling thread, kept between queries so that a point query
+		// costs its search and not the O(V) allocation of a space. A query leaves them empty
+		// again; they grow to the vertex count of the largest graph searched.
+		static SearchSpace& GetThreadSearchSpace(size_t vertex_count, bool is_forward) {
+			thread_local std::optional<SearchSpace> forward;
+			thread_local std::optional<SearchSpace> backward;
+			std::optional<SearchSpace>& space = is_forward ? forward : backward;
+			if (!space || space->weights.size() < vertex_count) {
+				space.emplace(vertex_count);
+			}
+			return *space;
+		}
+
+		// Weight of the backward search from a target at a vertex it settled
+		struct BucketEntry {
+			size_t target_index;
+			Weight weight;
+			EdgeId prev_edge; // towards the target
+		};
+
+		// Stall on demand: a vertex reached at less cost down an edge from a vertex contracted later
+		// is not on a shortest route up the hierarchy, so its edges are not followed
+		static bool IsStalled(const SearchGraph& reverse_graph, const SearchSpace& space, VertexId vertex,
+			Weight vertex_weight) {
+			return std::any_of(reverse_graph.edges.begin() + reverse_graph.offsets[vertex],
+				reverse_graph.edges.begin() + reverse_graph.offsets[vertex + 1], [&space, vertex_weight](const SearchEdge& edge) {
+					return space.weights[edge.vertex] && *space.weights[edge.vertex] + edge.weight < vertex_weight;
+				});
+		}
+
+		// Settles every vertex up the hierarchy from start, calling visit(vertex, weight) for
+		// those not stalled; the space is reset by the caller
+		template <typename Visit>
+		void SearchUpward(bool is_forward, VertexId start, SearchSpace& space, Visit visit) const {
+			const SearchGraph& search_graph = is_forward ? upward_ : downward_;
+			const SearchGraph& reverse_graph = is_forward ? downward_ : upward_;
+
+			space.reached_vertices.push_back(start);
+			space.weights[start] = ZERO_WEIGHT;
+			space.heap.PushOrDecrease(start, ZERO_WEIGHT);
+
+			while (!space.heap.Empty()) {
+				const VertexId vertex = space.heap.PopMin();
+				const Weight vertex_weight = *space.weights[vertex];
+				if (IsStalled(reverse_graph, space, vertex, vertex_weight)) {
+					continue;
+				}
+				visit(vertex, vertex_weight);
+				for (size_t index = search_graph.offsets[vertex]; index < search_graph.offsets[vertex + 1]; ++index) {
+					const SearchEdge& edge = search_graph.edges[index];
+					const Weight candidate_weight = vertex_weight + edge.weight;
+					if (!space.weights[edge.vertex]) {
+						space.reached_vertices.push_back(edge.vertex);
+					}
+					else if (!(candidate_weight < *space.weights[edge.vertex])) {
+						continue;
+					}
+					space.weights[edge.vertex] = candidate_weight;
+					space.prev_edges[edge.vertex] = edge.edge_id;
+					space.heap.PushOrDecrease(edge.vertex, candidate_weight);
+				}
+			}
+		}
+
+		// The weight is summed along the unpacked route, in the same order as a plain search does
+		RouteInfo UnpackRoute(const std::vector<EdgeId>& route_edges) const {
+			std::vector<EdgeId> edges;
+			Weight weight = ZERO_WEIGHT;
+			for (const EdgeId edge_id : route_edges) {
+				UnpackEdge(edge_id, edges);
+			}
+			for (const EdgeId edge_id : edges) {
+				weight += graph_.GetEdge(edge_id).weight;
+			}
+			return RouteInfo{ weight, std::move(edges) };
+		}
+
+		void CheckHierarchy() const {
+			const size_t vertex_count = graph_.GetVertexCount();
+			const size_t edge_count = graph_.GetEdgeCount();
+			const auto mismatch = std::invalid_argument("Contraction hierarchy does not match the graph");
+
+			if (hierarchy_.ranks.size() != vertex_count) {
+				throw mismatch;
+			}
+			std::vector<bool> is_ranked(vertex_count);
+			for (const VertexId rank : hierarchy_.ranks) {
+				if (rank >= vertex_count || is_ranked[rank]) {
+					throw mismatch;
+				}
+				is_ranked[rank] = true;
+			}
+			for (size_t index = 0; index < hierarchy_.shortcuts.size(); ++index) {
+				const auto& shortcut = hierarchy_.shortcuts[index];
+				if (shortcut.first_edge >= edge_count + index || shortcut.second_edge >= edge_count + index
+					|| GetEdgeFrom(shortcut.first_edge) != shortcut.from || GetEdgeTo(shortcut.second_edge) != shortcut.to
+					|| GetEdgeTo(shortcut.first_edge) != GetEdgeFrom(shortcut.second_edge)) {
+					throw mismatch;
+				}
+			}
+		}
+
+		// Every edge goes either up the hierarchy from its start, to the upward graph, or
+		// down to its end, to the downward graph, which the backward search walks up from the end
+		void InitSearchGraphs() {
+			const size_t vertex_count = graph_.GetVertexCount();
+			const size_t edge_count = graph_.GetEdgeCount() + hierarchy_.shortcuts.size();
+			const std::vector<VertexId>& ranks = hierarchy_.ranks;
+
+			upward_.offsets.assign(vertex_count + 1, 0);
+			downward_.offsets.assign(vertex_count + 1, 0);
+			for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+				const VertexId from = GetEdgeFrom(edge_id);
+				const VertexId to = GetEdgeTo(edge_id);
+				if (ranks[from] < ranks[to]) {
+					++upward_.offsets[from + 1];
+				}
+				else if (ranks[to] < ranks[from]) {
+					++downward_.offsets[to + 1];
+				}
+			}
+			std::partial_sum(upward_.offsets.begin(), upward_.offsets.end(), upward_.offsets.begin());
+			std::partial_sum(downward_.offsets.begin(), downward_.offsets.end(), downward_.offsets.begin());
+
+			upward_.edges.resize(upward_.offsets.back());
+			downward_.edges.resize(downward_.offsets.back());
+			std::vector<size_t> upward_positions(upward_.offsets.begin(), std::prev(upward_.offsets.end()));
+			std::vector<size_t> downward_positions(downward_.offsets.begin(), std::prev(downward_.offsets.end()));
+
+			for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+				const VertexId from = GetEdgeFrom(edge_id);
+				const VertexId to = GetEdgeTo(edge_id);
+				if (ranks[from] < ranks[to]) {
+					upward_.edges[upward_positions[from]++] = SearchEdge{ to, GetEdgeWeight(edge_id), edge_id };
+				}
+				else if (ranks[to] < ranks[from]) {
+					downward_.edges[downward_positions[to]++] = SearchEdge{ from, GetEdgeWeight(edge_id), edge_id };
+				}
+			}
+			KeepLightestEdges(upward_);
+			KeepLightestEdges(downward_);
+		}
+
+		static void KeepLightestEdges(SearchGraph& search_graph) {
+			size_t kept_count = 0;
+			for (size_t vertex = 0; vertex + 1 < search_graph.offsets.size(); ++vertex) {
+				const auto begin = search_graph.edges.begin() + search_graph.offsets[vertex];
+				const auto end = search_graph.edges.begin() + search_graph.offsets[vertex + 1];
+				std::sort(begin, end, [](const SearchEdge& lhs, const SearchEdge& rhs) {
+					return std::tie(lhs.vertex, lhs.weight, lhs.edge_id) < std::tie(rhs.vertex, rhs.weight, rhs.edge_id);
+				});
+				search_graph.offsets[vertex] = kept_count;
+				for (auto it = begin; it != end; ++it) {
+					if (it == begin || it->vertex != search_graph.edges[kept_count - 1].vertex) {
+						search_graph.edges[kept_count++] = *it;
+					}
+				}
+			}
+			search_graph.offsets.back() = kept_count;
+			search_graph.edges.resize(kept_count);
+			search_graph.edges.shrink_to_fit();
+		}
+
+		VertexId GetEdgeFrom(EdgeId edge_id) const {
+			const size_t edge_count = graph_.GetEdgeCount();
+			return edge_id < edge_count ? graph_.GetEdge(edge_id).from : hierarchy_.shortcuts[edge_id - edge_count].from;
+		}
+
+		VertexId GetEdgeTo(EdgeId edge_id) const {
+			const size_t edge_count = graph_.GetEdgeCount();
+			return edge_id < edge_count ? graph_.GetEdge(edge_id).to : hierarchy_.shortcuts[edge_id - edge_count].to;
+		}
+
+		Weight GetEdgeWeight(EdgeId edge_id) const {
+			const size_t edge_count = graph_.GetEdgeCount();
+			return edge_id < edge_count ? graph_.GetEdge(edge_id).weight : hierarchy_.shortcuts[edge_id - edge_count].weight;
+		}
+
+		// Appends the graph edges the edge or shortcut stands for, in route order
+		void UnpackEdge(EdgeId edge_id, std::vector<EdgeId>& edges) const {
+			const size_t edge_count = graph_.GetEdgeCount();
+			std::vector<EdgeId> pending{ edge_id };
+			while (!pending.empty()) {
+				const EdgeId pending_id = pending.back();
+				pending.pop_back();
+				if (pending_id < edge_count) {
+					edges.push_back(pending_id);
+					continue;
+				}
+				const auto& shortcut = hierarchy_.shortcuts[pending_id - edge_count];
+				pending.push_back(shortcut.second_edge);
+				pending.push_back(shortcut.first_edge);
+			}
+		}
+
+		static constexpr Weight ZERO_WEIGHT{};
+		static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+		const Graph& graph_;
+		HierarchyInternalData hierarchy_;
+		SearchGraph upward_;
+		SearchGraph downward_;
+	};
+
+	template <typename Weight>
+	ContractionRouter<Weight>::ContractionRouter(const Graph& graph)
+		: graph_(graph)
+		, hierarchy_(detail::HierarchyBuilder<Weight>(graph).Build())
+	{
+		InitSearchGraphs();
+	}
+
+	template <typename Weight>
+	ContractionRouter<Weight>::ContractionRouter(const Graph& graph, HierarchyInternalData&& hierarchy)
+		: graph_(graph)
+		, hierarchy_(std::move(hierarchy))
+	{
+		CheckHierarchy();
+		InitSearchGraphs();
+	}
+
+	template <typename Weight>
+	std::optional<typename ContractionRouter<Weight>::RouteInfo> ContractionRouter<Weight>::BuildRoute(VertexId from,
+		VertexId to) const {
+		const size_t vertex_count = graph_.GetVertexCount();
+		if (from >= vertex_count || to >= vertex_count) {
+			throw std::out_of_range("Vertex id is out of range");
+		}
+		if (from == to) {
+			return RouteInfo{ ZERO_WEIGHT, {} };
+		}
+
+		SearchSpace& forward = GetThreadSearchSpace(vertex_count, true);
+		SearchSpace& backward = GetThreadSearchSpace(vertex_count, false);
+		const SearchSpaceReset forward_reset(forward);
+		const SearchSpaceReset backward_reset(backward);
+
+		// A vertex is recorded as reached before it gets a weight, so the reset always finds it
+		forward.reached_vertices.push_back(from);
+		forward.weights[from] = ZERO_WEIGHT;
+		forward.heap.PushOrDecrease(from, ZERO_WEIGHT);
+		backward.reached_vertices.push_back(to);
+		backward.weights[to] = ZERO_WEIGHT;
+		backward.heap.PushOrDecrease(to, ZERO_WEIGHT);
+
+		std::optional<Weight> best_weight;
+		VertexId meeting_vertex = from;
+		bool is_forward = false;
+
+		// A direction stops once its nearest vertex is no closer than the best route found
+		while (!forward.heap.Empty() || !backward.heap.Empty()) {
+			is_forward = backward.heap.Empty() || (!is_forward && !forward.heap.Empty());
+			SearchSpace& space = is_forward ? forward : backward;
+			const SearchSpace& other_space = is_forward ? backward : forward;
+			const SearchGraph& search_graph = is_forward ? upward_ : downward_;
+
+			const VertexId vertex = space.heap.PopMin();
+			const Weight vertex_weight = *space.weights[vertex];
+			if (best_weight && !(vertex_weight < *best_weight)) {
+				space.heap.Clear();
+				continue;
+			}
+			if (other_space.weights[vertex]) {
+				const Weight route_weight = vertex_weight + *other_space.weights[vertex];
+				if (!best_weight || route_weight < *best_weight) {
+					best_weight = route_weight;
+					meeting_vertex = vertex;
+				}
+			}
+			if (IsStalled(is_forward ? downward_ : upward_, space, vertex, vertex_weight)) {
+				continue;
+			}
+			for (size_t index = search_graph.offsets[vertex]; index < search_graph.offsets[vertex + 1]; ++index) {
+				const SearchEdge& edge = search_graph.edges[index];
+				const Weight candidate_weight = vertex_weight + edge.weight;
+				if (!space.weights[edge.vertex]) {
+					space.reached_vertices.push_back(edge.vertex);
+				}
+				else if (!(candidate_weight < *space.weights[edge.vertex])) {
+					continue;
+				}
+				space.weights[edge.vertex] = candidate_weight;
+				space.prev_edges[edge.vertex] = edge.edge_id;
+				space.heap.PushOrDecrease(edge.vertex, candidate_weight);
+			}
+		}
+
+		if (!best_weight) {
+			return std::nullopt;
+		}
+		std::vector<EdgeId> route_edges;
+		for (VertexId vertex = meeting_vertex; vertex != from; vertex = GetEdgeFrom(forward.prev_edges[vertex])) {
+			route_edges.push_back(forward.prev_edges[vertex]);
+		}
+		std::reverse(route_edges.begin(), route_edges.end());
+		for (VertexId vertex = meeting_vertex; vertex != to; vertex = GetEdgeTo(backward.prev_edges[vertex])) {
+			route_edges.push_back(backward.prev_edges[vertex]);
+		}
+		return UnpackRoute(route_edges);
+	}
+
+	template <typename Weight>
+	std::vector<std::vector<std::optional<typename ContractionRouter<Weight>::RouteInfo>>> ContractionRouter<Weight>::BuildRoutes(
+		const std::vector<VertexId>& sources, const std::vector<VertexId>& targets, bool with_edges) const {
+		const size_t vertex_count = graph_.GetVertexCount();
+		const auto is_out_of_range = [vertex_count](VertexId vertex) { return vertex >= vertex_count; };
+		if (std::any_of(sources.begin(), sources.end(), is_out_of_range)
+			|| std::any_of(targets.begin(), targets.end(), is_out_of_range)) {
+			throw std::out_of_range("Vertex id is out of range");
+		}
+
+		SearchSpace space(vertex_count);
+
+		// The entries of every bucket are in target order
+		std::vector<std::vector<BucketEntry>> buckets(vertex_count);
+		for (size_t target_index = 0; target_index < targets.size(); ++target_index) {
+			SearchUpward(false, targets[target_index], space,
+				[&buckets, &space, target_index](VertexId vertex, Weight weight) {
+					buckets[vertex].push_back(BucketEntry{ target_index, weight, space.prev_edges[vertex] });
+				});
+			space.Reset();
+		}
+		const auto find_entry = [&buckets](VertexId vertex, size_t target_index) {
+			return *std::lower_bound(buckets[vertex].begin(), buckets[vertex].end(), target_index,
+				[](const BucketEntry& entry, size_t index) { return entry.target_index < index; });
+		};
+
+		std::vector<std::vector<std::optional<RouteInfo>>> routes;
+		routes.reserve(sources.size());
+		std::vector<std::optional<Weight>> best_weights;
+		std::vector<VertexId> meeting_vertices(targets.size());
+
+		for (const VertexId from : sources) {
+			best_weights.assign(targets.size(), std::nullopt);
+			SearchUpward(true, from, space,
+				[&buckets, &best_weights, &meeting_vertices](VertexId vertex, Weight weight) {
+					for (const BucketEntry& entry : buckets[vertex]) {
+						const Weight route_weight = weight + entry.weight;
+						std::optional<Weight>& best_weight = best_weights[entry.target_index];
+						if (!best_weight || route_weight < *best_weight) {
+							best_weight = route_weight;
+							meeting_vertices[entry.target_index] = vertex;
+						}
+					}
+				});
+
+			std::vector<std::optional<RouteInfo>>& row = routes.emplace_back();
+			row.reserve(targets.size());
+			for (size_t target_index = 0; target_index < targets.size(); ++target_index) {
+				if (!best_weights[target_index]) {
+					row.push_back(std::nullopt);
+					continue;
+				}
+				if (!with_edges) {
+					row.push_back(RouteInfo{ *best_weights[target_index], {} });
+					continue;
+				}
+				std::vector<EdgeId> route_edges;
+				const VertexId meeting_vertex = meeting_vertices[target_index];
+				for (VertexId vertex = meeting_vertex; vertex != from; vertex = GetEdgeFrom(space.prev_edges[vertex])) {
+					route_edges.push_back(space.prev_edges[vertex]);
+				}
+				std::reverse(route_edges.begin(), route_edges.end());
+				for (VertexId vertex = meeting_vertex; vertex != targets[target_index];) {
+					const EdgeId edge_id = find_entry(vertex, target_index).prev_edge;
+					route_edges.push_back(edge_id);
+					vertex = GetEdgeTo(edge_id);
+				}
+				row.push_back(UnpackRoute(route_edges));
+			}
+			space.Reset();
+		}
+		return routes;
+	}
+
+	template <typename Weight>
+	const typename ContractionRouter<Weight>::HierarchyInternalData& ContractionRouter<Weight>::GetHierarchyInternalData() const {
+		return hierarchy_;
+	}
+}  // namespace graph
\ No newline at end of file
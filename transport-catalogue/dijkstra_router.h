@@ -0,0 +1,289 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+	// Binary min-heap of vertices keyed by their current distance.
+	// Stores the heap position of every vertex, so decreasing a key is O(log V)
+	// and each vertex is kept in the heap at most once.
+	template <typename Weight>
+	class IndexedHeap {
+	public:
+		explicit IndexedHeap(size_t vertex_count)
+			: positions_(vertex_count, NOT_IN_HEAP) {
+		}
+
+		bool Empty() const {
+			return heap_.empty();
+		}
+
+		bool Contains(VertexId vertex) const {
+			return positions_[vertex] != NOT_IN_HEAP;
+		}
+
+		void PushOrDecrease(VertexId vertex, Weight key) {
+			if (!Contains(vertex)) {
+				// Pushed first, so a failed allocation leaves the vertex out of the heap
+				heap_.push_back({ key, vertex });
+				positions_[vertex] = heap_.size() - 1;
+			}
+			else {
+				heap_[positions_[vertex]].key = key;
+			}
+			SiftUp(positions_[vertex]);
+		}
+
+		VertexId PopMin() {
+			const VertexId vertex = heap_.front().vertex;
+			Swap(0, heap_.size() - 1);
+			heap_.pop_back();
+			positions_[vertex] = NOT_IN_HEAP;
+			if (!heap_.empty()) {
+				SiftDown(0);
+			}
+			return vertex;
+		}
+
+		// Empties the heap in time linear in its size, not in the vertex count
+		void Clear() {
+			for (const Item& item : heap_) {
+				positions_[item.vertex] = NOT_IN_HEAP;
+			}
+			heap_.clear();
+		}
+
+	private:
+		struct Item {
+			Weight key;
+			VertexId vertex;
+		};
+
+		void Swap(size_t lhs, size_t rhs) {
+			std::swap(heap_[lhs], heap_[rhs]);
+			positions_[heap_[lhs].vertex] = lhs;
+			positions_[heap_[rhs].vertex] = rhs;
+		}
+
+		void SiftUp(size_t index) {
+			while (index > 0) {
+				const size_t parent = (index - 1) / 2;
+				if (!(heap_[index].key < heap_[parent].key)) {
+					break;
+				}
+				Swap(index, parent);
+				index = parent;
+			}
+		}
+
+		void SiftDown(size_t index) {
+			for (;;) {
+				size_t smallest = index;
+				for (size_t child = 2 * index + 1; child <= 2 * index + 2 && child < heap_.size(); ++child) {
+					if (heap_[child].key < heap_[smallest].key) {
+						smallest = child;
+					}
+				}
+				if (smallest == index) {
+					break;
+				}
+				Swap(index, smallest);
+				index = smallest;
+			}
+		}
+
+		static constexpr size_t NOT_IN_HEAP = std::numeric_limits<size_t>::max();
+		std::vector<Item> heap_;
+		std::vector<size_t> positions_;
+	};
+
+	// Answers each query with a single-source Dijkstra search which stops as soon
+	// as the target vertex is settled. Nothing is precomputed, so construction is
+	// O(E) and memory does not depend on the number of vertex pairs. The search
+	// walks a frozen copy of the graph, which keeps the edges of a vertex together.
+	template <typename Weight>
+	class DijkstraRouter {
+	private:
+		using Graph = DirectedWeightedGraph<Weight>;
+
+	public:
+		using RouteInfo = typename Router<Weight>::RouteInfo;
+
+		explicit DijkstraRouter(const Graph& graph);
+
+		std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+		// Routes from one vertex to each of targets, in their order, from a single search
+		// which stops once all of them are settled
+		std::vector<std::optional<RouteInfo>> BuildRoutes(VertexId from, const std::vector<VertexId>& targets) const;
+
+		// Shortest routes from the root to every vertex it reaches, kept to answer later
+		// queries from the same root without a search
+		struct ShortestPathTree {
+			VertexId root;
+			std::vector<Weight> weights; // meaningful for the reached vertices only
+			std::vector<EdgeId> prev_edges; // NO_EDGE for the root and the vertices not reached
+		};
+
+		ShortestPathTree BuildTree(VertexId from) const;
+
+		std::optional<RouteInfo> BuildRoute(const ShortestPathTree& tree, VertexId to) const;
+
+		static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+	private:
+		// Settles vertices from `from` in order of weight until is_last(vertex) holds for a settled one
+		template <typename IsLast>
+		void Search(VertexId from, std::vector<std::optional<Weight>>& weights, std::vector<EdgeId>& prev_edges,
+			IsLast is_last) const;
+
+		std::vector<EdgeId> TraceRoute(VertexId from, VertexId to, const std::vector<EdgeId>& prev_edges) const;
+
+		void CheckVertex(VertexId vertex) const {
+			if (vertex >= graph_.GetVertexCount()) {
+				throw std::out_of_range("Vertex id is out of range");
+			}
+		}
+
+		static constexpr Weight ZERO_WEIGHT{};
+		const Graph& graph_;
+		FrozenWeightedGraph<Weight> frozen_graph_;
+	};
+
+	template <typename Weight>
+	DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph)
+		: graph_(graph)
+		, frozen_graph_(graph)
+	{
+		for (const auto& edge : graph.GetEdges()) {
+			if (edge.weight < ZERO_WEIGHT) {
+				throw std::domain_error("Edges' weights should be non-negative");
+			}
+		}
+	}
+
+	template <typename Weight>
+	template <typename IsLast>
+	void DijkstraRouter<Weight>::Search(VertexId from, std::vector<std::optional<Weight>>& weights,
+		std::vector<EdgeId>& prev_edges, IsLast is_last) const {
+		IndexedHeap<Weight> heap(graph_.GetVertexCount());
+
+		weights[from] = ZERO_WEIGHT;
+		heap.PushOrDecrease(from, ZERO_WEIGHT);
+
+		while (!heap.Empty()) {
+			const VertexId vertex = heap.PopMin();
+			if (is_last(vertex)) {
+				break;
+			}
+			const Weight vertex_weight = *weights[vertex];
+			for (const auto& edge : frozen_graph_.GetOutgoingEdges(vertex)) {
+				const Weight candidate_weight = vertex_weight + edge.weight;
+				if (!weights[edge.to] || candidate_weight < *weights[edge.to]) {
+					weights[edge.to] = candidate_weight;
+					prev_edges[edge.to] = edge.id;
+					heap.PushOrDecrease(edge.to, candidate_weight);
+				}
+			}
+		}
+	}
+
+	template <typename Weight>
+	std::vector<EdgeId> DijkstraRouter<Weight>::TraceRoute(VertexId from, VertexId to,
+		const std::vector<EdgeId>& prev_edges) const {
+		std::vector<EdgeId> edges;
+		for (VertexId vertex = to; vertex != from; vertex = graph_.GetEdge(prev_edges[vertex]).from) {
+			edges.push_back(prev_edges[vertex]);
+		}
+		std::reverse(edges.begin(), edges.end());
+		return edges;
+	}
+
+	template <typename Weight>
+	std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+		VertexId to) const {
+		CheckVertex(from);
+		CheckVertex(to);
+
+		std::vector<std::optional<Weight>> weights(graph_.GetVertexCount());
+		std::vector<EdgeId> prev_edges(graph_.GetVertexCount(), NO_EDGE);
+		Search(from, weights, prev_edges, [to](VertexId vertex) { return vertex == to; });
+
+		if (!weights[to]) {
+			return std::nullopt;
+		}
+		return RouteInfo{ *weights[to], TraceRoute(from, to, prev_edges) };
+	}
+
+	template <typename Weight>
+	std::vector<std::optional<typename DijkstraRouter<Weight>::RouteInfo>> DijkstraRouter<Weight>::BuildRoutes(VertexId from,
+		const std::vector<VertexId>& targets) const {
+		CheckVertex(from);
+		std::for_each(targets.begin(), targets.end(), [this](VertexId to) { CheckVertex(to); });
+
+		const size_t vertex_count = graph_.GetVertexCount();
+		std::vector<std::optional<Weight>> weights(vertex_count);
+		std::vector<EdgeId> prev_edges(vertex_count, NO_EDGE);
+		std::vector<bool> is_target(vertex_count);
+
+		size_t unsettled_count = 0;
+		for (const VertexId to : targets) {
+			if (!is_target[to]) {
+				is_target[to] = true;
+				++unsettled_count;
+			}
+		}
+		if (unsettled_count != 0) {
+			Search(from, weights, prev_edges, [&is_target, &unsettled_count](VertexId vertex) {
+				return is_target[vertex] && --unsettled_count == 0;
+			});
+		}
+
+		std::vector<std::optional<RouteInfo>> routes;
+		routes.reserve(targets.size());
+		for (const VertexId to : targets) {
+			if (!weights[to]) {
+				routes.push_back(std::nullopt);
+				continue;
+			}
+			routes.push_back(RouteInfo{ *weights[to], TraceRoute(from, to, prev_edges) });
+		}
+		return routes;
+	}
+
+	template <typename Weight>
+	typename DijkstraRouter<Weight>::ShortestPathTree DijkstraRouter<Weight>::BuildTree(VertexId from) const {
+		CheckVertex(from);
+
+		const size_t vertex_count = graph_.GetVertexCount();
+		std::vector<std::optional<Weight>> weights(vertex_count);
+		ShortestPathTree tree{ from, std::vector<Weight>(vertex_count, ZERO_WEIGHT), std::vector<EdgeId>(vertex_count, NO_EDGE) };
+		Search(from, weights, tree.prev_edges, [](VertexId) { return false; });
+
+		for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+			if (weights[vertex]) {
+				tree.weights[vertex] = *weights[vertex];
+			}
+		}
+		return tree;
+	}
+
+	template <typename Weight>
+	std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(
+		const ShortestPathTree& tree, VertexId to) const {
+		CheckVertex(to);
+
+		if (to != tree.root && tree.prev_edges[to] == NO_EDGE) {
+			return std::nullopt;
+		}
+		return RouteInfo{ tree.weights[to], TraceRoute(tree.root, to, tree.prev_edges) };
+	}
+}  // namespace graph
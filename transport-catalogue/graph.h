@@ -2,7 +2,10 @@
 
 #include "ranges.h"
 
+#include <cstdint>
 #include <cstdlib>
+#include <limits>
+#include <stdexcept>
 #include <vector>
 
 namespace graph {
@@ -26,6 +29,8 @@ private:
 public:
 	DirectedWeightedGraph() = default;
 	explicit DirectedWeightedGraph(size_t vertex_count);
+	// Same graph as adding the edges one by one in their order
+	DirectedWeightedGraph(size_t vertex_count, std::vector<Edge<Weight>>&& edges);
 	EdgeId AddEdge(const Edge<Weight>& edge);
 
 	size_t GetVertexCount() const;
@@ -50,6 +55,26 @@ DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
 	: vertex_to_edges_id_(vertex_count) {
 }
 
+template <typename Weight>
+DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count, std::vector<Edge<Weight>>&& edges)
+	: edges_(std::move(edges))
+	, vertex_to_edges_id_(vertex_count) {
+
+	std::vector<size_t> incident_edge_counts(vertex_count);
+	for (const Edge<Weight>& edge : edges_) {
+		if (edge.from >= vertex_count || edge.to >= vertex_count) {
+			throw std::out_of_range("Edge vertex id is out of range");
+		}
+		++incident_edge_counts[edge.from];
+	}
+	for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+		vertex_to_edges_id_[vertex].reserve(incident_edge_counts[vertex]);
+	}
+	for (EdgeId id = 0; id < edges_.size(); ++id) {
+		vertex_to_edges_id_[edges_[id].from].push_back(id);
+	}
+}
+
 template <typename Weight>
 EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
 	edges_.push_back(edge);
@@ -78,4 +103,72 @@ typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
 	return ranges::AsRange(vertex_to_edges_id_.at(vertex));
 }
+
+// Read-only copy of a graph in compressed sparse row form: the outgoing edges of all
+// vertices in one array, those of each vertex contiguous and in edge id order, each with
+// its target and weight. Relaxing a vertex reads one run of that array instead of
+// following edge ids into the edge list. Vertex ids are not range-checked.
+template <typename Weight>
+class FrozenWeightedGraph {
+public:
+	struct OutgoingEdge {
+		uint32_t to;
+		uint32_t id;
+		Weight weight;
+	};
+
+	using OutgoingEdgesRange = ranges::Range<const OutgoingEdge*>;
+
+	FrozenWeightedGraph() = default;
+	explicit FrozenWeightedGraph(const DirectedWeightedGraph<Weight>& graph);
+
+	size_t GetVertexCount() const;
+	size_t GetEdgeCount() const;
+	OutgoingEdgesRange GetOutgoingEdges(VertexId vertex) const;
+
+private:
+	std::vector<size_t> offsets_; // vertex_count + 1, edges of vertex v are [offsets_[v], offsets_[v + 1])
+	std::vector<OutgoingEdge> edges_;
+};
+
+template <typename Weight>
+FrozenWeightedGraph<Weight>::FrozenWeightedGraph(const DirectedWeightedGraph<Weight>& graph)
+	: offsets_(graph.GetVertexCount() + 1, 0) {
+
+	const size_t vertex_count = graph.GetVertexCount();
+	const std::vector<Edge<Weight>>& edges = graph.GetEdges();
+
+	if (vertex_count > std::numeric_limits<uint32_t>::max() || edges.size() > std::numeric_limits<uint32_t>::max()) {
+		throw std::length_error("Too many vertices or edges for a frozen graph");
+	}
+	for (const Edge<Weight>& edge : edges) {
+		++offsets_[edge.from + 1];
+	}
+	for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+		offsets_[vertex + 1] += offsets_[vertex];
+	}
+	edges_.resize(edges.size());
+	std::vector<size_t> positions(offsets_.begin(), offsets_.end() - 1);
+
+	for (EdgeId id = 0; id < edges.size(); ++id) {
+		edges_[positions[edges[id].from]++] = OutgoingEdge{ static_cast<uint32_t>(edges[id].to), static_cast<uint32_t>(id),
+															edges[id].weight };
+	}
+}
+
+template <typename Weight>
+size_t FrozenWeightedGraph<Weight>::GetVertexCount() const {
+	return offsets_.empty() ? 0 : offsets_.size() - 1;
+}
+
+template <typename Weight>
+size_t FrozenWeightedGraph<Weight>::GetEdgeCount() const {
+	return edges_.size();
+}
+
+template <typename Weight>
+typename FrozenWeightedGraph<Weight>::OutgoingEdgesRange
+FrozenWeightedGraph<Weight>::GetOutgoingEdges(VertexId vertex) const {
+	return OutgoingEdgesRange{ edges_.data() + offsets_[vertex], edges_.data() + offsets_[vertex + 1] };
+}
 }  // namespace graph
\ No newline at end of file
@@ -1,219 +1,403 @@
-#include "json.h"
-#include "json_reader.h"
-#include "transport_catalogue.h"
-#include "map_renderer.h"
-#include "transport_router.h"
-
-#include <transport_catalogue.pb.h>
-#include <istream>
-#include <vector>
-
-using namespace std;
-using namespace transport;
-using namespace json;
-using namespace geo;
-using namespace renderer;
-
-void Requests::Add(Request&& request) {
-	requests_.push_back(move(request));
-}
-
-void Requests::SetRouteRequestPresence() {
-	has_route_request_ = true;
-}
-
-bool Requests::IsRouteRequestPresence() const {
-	return has_route_request_;
-}
-
-vector<Request>::iterator Requests::begin() {
-	return requests_.begin();
-}
-vector<Request>::iterator Requests::end() {
-	return requests_.end();
-}
-vector<Request>::const_iterator Requests::begin() const {
-	return requests_.cbegin();
-}
-vector<Request>::const_iterator Requests::end() const {
-	return requests_.cend();
-}
-
-
-void ReadBaseRequests(Array& base_requests, serialize::TransportCatalogue& serialize_transport);
-void ReadRenderSettings(Dict& render_settings, serialize::RenderSettings& render_attrs);
-void ReadRoutingSettings(const Dict& routing_settings, serialize::RoutingSettings& routing_attrs);
-
-void ReadInput(	std::istream& is, serialize::TransportCatalogue& serialize_transport, 
-				filesystem::path& serialize_result_path) {
-	
-	Node node = LoadNode(is);
-
-	serialize_result_path = node.AsDict().at("serialization_settings"s).AsDict().at("file"s).AsString();
-
-	Array& base_requests = node.AsDict().at("base_requests"s).AsArray();
-	ReadBaseRequests(base_requests, serialize_transport);
-
-	Dict& render_settings = node.AsDict().at("render_settings"s).AsDict();
-	ReadRenderSettings(render_settings , *serialize_transport.mutable_render_settings());
-
-	Dict& routing_settings = node.AsDict().at("routing_settings"s).AsDict();
-	ReadRoutingSettings(routing_settings, *serialize_transport.mutable_routing_settings());
-}
-
-void ReadStatRequests(Array& stat_requests, Requests& requests);
-
-void ReadInput(std::istream& is, Requests& requests, std::filesystem::path& serialize_result_path) {
-
-	Node node = LoadNode(is);
-
-	serialize_result_path = node.AsDict().at("serialization_settings"s).AsDict().at("file"s).AsString();
-
-	Array& stat_requests = node.AsDict().at("stat_requests"s).AsArray();
-	ReadStatRequests(stat_requests, requests);
-}
-
-void ReadStopDataRequest(json::Dict& request, serialize::StopData* stop_data);
-void ReadBusDataRequest(json::Dict& request, serialize::BusData* bus_data);
-
-void ReadBaseRequests(Array& base_requests, serialize::TransportCatalogue& serialize_transport) {
-
-	for (Node& node_request : base_requests) {
-
-		Dict& request = node_request.AsDict();
-
-		if (request.at("type"s) == "Stop"s) {
-			ReadStopDataRequest(request, serialize_transport.add_stops_data());
-		}
-		else if (request.at("type"s) == "Bus"s) {
-			ReadBusDataRequest(request, serialize_transport.add_buses_data());
-		}
-	}
-}
-
-void ReadJsonToPoint(const json::Node& point, serialize::Point& serialize_point);
-void ReadJsonToColor(json::Node& color, serialize::Color& serialize_color);
-
-void ReadRenderSettings(Dict& render_settings, serialize::RenderSettings& render_attrs) {
-
-	render_attrs.set_map_width(render_settings.at("width"s).AsDouble());
-	render_attrs.set_map_height(render_settings.at("height"s).AsDouble());
-	render_attrs.set_map_padding(render_settings.at("padding"s).AsDouble());
-	render_attrs.set_stop_radius(render_settings.at("stop_radius"s).AsDouble());
-	render_attrs.set_line_width(render_settings.at("line_width"s).AsDouble());
-	render_attrs.set_bus_label_font_size(static_cast<uint32_t>(render_settings.at("bus_label_font_size"s).AsInt()));
-	render_attrs.set_stop_label_font_size(static_cast<uint32_t>(render_settings.at("stop_label_font_size"s).AsInt()));
-	render_attrs.set_underlayer_width(render_settings.at("underlayer_width"s).AsDouble());
-
-	ReadJsonToPoint(render_settings.at("bus_label_offset"s), *render_attrs.mutable_bus_label_offset());
-	ReadJsonToPoint(render_settings.at("stop_label_offset"s), *render_attrs.mutable_stop_label_offset());
-	ReadJsonToColor(render_settings.at("underlayer_color"s), *render_attrs.mutable_underlayer_color());
-	
-	json::Array color_palette = render_settings.at("color_palette"s).AsArray();
-	for (json::Node& color : color_palette) {
-		ReadJsonToColor(color, *render_attrs.add_stroke_colors());
-	}
-}
-
-void ReadJsonToPoint(const json::Node& point, serialize::Point& serialize_point) {
-	json::Array coordinates = point.AsArray();
-	serialize_point.set_x(coordinates[0].AsDouble());
-	serialize_point.set_y(coordinates[1].AsDouble());
-}
-
-void ReadJsonToColor(json::Node& color, serialize::Color& serialize_color) {
-
-	if (color.IsString()) {
-		serialize_color.set_color_str(move(color.AsString()));
-	}
-	else {
-		uint8_t red = static_cast<uint8_t>(color.AsArray()[0].AsInt());
-		uint8_t green = static_cast<uint8_t>(color.AsArray()[1].AsInt());
-		uint8_t blue = static_cast<uint8_t>(color.AsArray()[2].AsInt());
-
-		serialize_color.set_red(red);
-		serialize_color.set_green(green);
-		serialize_color.set_blue(blue);
-
-		if (color.AsArray().size() == 4) {
-			double opacity = color.AsArray()[3].AsDouble();
-			serialize_color.mutable_opacity()->set_value(opacity);
-		}
-	}
-}
-
-void ReadStatRequests(Array& stat_requests, Requests& requests) {
-	for (Node& request : stat_requests) {
-
-		int id = request.AsDict().at("id"s).AsInt();
-		const string& type_request = request.AsDict().at("type"s).AsString();
-		TypeRequest type;
-
-		if (type_request == "Bus"s) {
-			type = TypeRequest::BUS;
-		}
-		else if (type_request == "Stop"s) {
-			type = TypeRequest::STOP;
-		}
-		else if (type_request == "Map"s) {
-			type = TypeRequest::MAP;
-		}
-		else {
-			type = TypeRequest::ROUTE;
-			requests.SetRouteRequestPresence();
-		}
-
-		string name;
-
-		if (type == TypeRequest::BUS || type == TypeRequest::STOP) {
-			name = move(request.AsDict().at("name"s).AsString());
-		}
-
-		RouteFinalStops final_stops;
-
-		if (type == TypeRequest::ROUTE) {
-			final_stops.from = move(request.AsDict().at("from"s).AsString());
-			final_stops.to = move(request.AsDict().at("to"s).AsString());
-		}
-
-		requests.Add(Request{ id , move(name), type, move(final_stops) });
-	}
-}
-
-void ReadStopDataRequest(json::Dict& request, serialize::StopData* stop_data) {
-
-	stop_data->set_name(move(request.at("name"s).AsString()));
-	stop_data->set_latitude(request.at("latitude"s).AsDouble());
-	stop_data->set_longitude(request.at("longitude"s).AsDouble());
-
-	if (auto it = request.find("road_distances"s); it != request.end()) {
-
-		Dict& node_distances = it->second.AsDict();
-
-		for (auto& [stop_name, distance] : node_distances) {
-
-			auto road_distance = stop_data->add_road_distances();
-			road_distance->set_stop_name(move(stop_name));
-			road_distance->set_distance(distance.AsInt());
-		}
-	}
-}
-
-void ReadBusDataRequest(json::Dict& request, serialize::BusData* bus_data) {
-
-	bus_data->set_is_roundtrip(request.at("is_roundtrip"s).AsBool());
-	bus_data->set_name(move(request.at("name"s).AsString()));
-
-	list<string> bus_path;
-
-	for (Node& stop : request.at("stops"s).AsArray()) {
-
-		*bus_data->add_stops() = move(stop.AsString());
-	}
-}
-
-void ReadRoutingSettings(const Dict& routing_settings, serialize::RoutingSettings& routing_attrs) {
-
-	routing_attrs.set_bus_velocity(routing_settings.at("bus_velocity"s).AsDouble());
-	routing_attrs.set_bus_wait_time(static_cast<size_t>(routing_settings.at("bus_wait_time"s).AsInt()));
+#include "json.h"
+#include "json_reader.h"
+#include "transport_catalogue.h"
+#include "map_renderer.h"
+#include "transport_router.h"
+
+#include <transport_catalogue.pb.h>
+#include <istream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+using namespace transport;
+using namespace json;
+using namespace geo;
+using namespace renderer;
+
+void Requests::Add(Request&& request) {
+
+	switch (request.type) {
+	case TypeRequest::BUS:
+		break;
+	case TypeRequest::STOP:
+		base_parts_.stops = true;
+		base_parts_.bus_paths = true;
+		break;
+	case TypeRequest::MAP:
+		base_parts_.stops = true;
+		base_parts_.bus_paths = true;
+		base_parts_.render_settings = true;
+		break;
+	case TypeRequest::ROUTE:
+	case TypeRequest::ROUTE_MATRIX:
+		base_parts_.routes = true;
+		break;
+	}
+	requests_.push_back(move(request));
+}
+
+bool Requests::IsRouteRequestPresence() const {
+	return base_parts_.routes;
+}
+
+const BaseParts& Requests::GetBaseParts() const {
+	return base_parts_;
+}
+
+vector<Request>::iterator Requests::begin() {
+	return requests_.begin();
+}
+vector<Request>::iterator Requests::end() {
+	return requests_.end();
+}
+vector<Request>::const_iterator Requests::begin() const {
+	return requests_.cbegin();
+}
+vector<Request>::const_iterator Requests::end() const {
+	return requests_.cend();
+}
+
+
+void ReadBaseRequests(Array& base_requests, serialize::TransportCatalogue& serialize_transport);
+void ReadRenderSettings(Dict& render_settings, serialize::RenderSettings& render_attrs);
+void ReadRoutingSettings(const Dict& routing_settings, serialize::RoutingSettings& routing_attrs);
+
+void ReadSerializationSettings(const Dict& settings, SerializationSettings& serialization_settings);
+
+void ReadInput(	std::istream& is, serialize::TransportCatalogue& serialize_transport, 
+				SerializationSettings& serialization_settings) {
+	
+	Node node = LoadNode(is);
+
+	ReadSerializationSettings(node.AsDict().at("serialization_settings"s).AsDict(), serialization_settings);
+
+	Array& base_requests = node.AsDict().at("base_requests"s).AsArray();
+	ReadBaseRequests(base_requests, serialize_transport);
+
+	Dict& render_settings = node.AsDict().at("render_settings"s).AsDict();
+	ReadRenderSettings(render_settings , *serialize_transport.mutable_render_settings());
+
+	Dict& routing_settings = node.AsDict().at("routing_settings"s).AsDict();
+	ReadRoutingSettings(routing_settings, *serialize_transport.mutable_routing_settings());
+}
+
+void ReadBaseDeltaRequests(Array& base_requests, BaseDelta& delta);
+
+// The base is read from "base_file" if it is given and from "file" otherwise
+void ReadInput(std::istream& is, BaseDelta& delta, SerializationSettings& serialization_settings) {
+
+	Node node = LoadNode(is);
+
+	const Dict& settings = node.AsDict().at("serialization_settings"s).AsDict();
+	ReadSerializationSettings(settings, serialization_settings);
+
+	if (auto it = settings.find("base_file"s); it != settings.end()) {
+		delta.base_file = it->second.AsString();
+	}
+	else {
+		delta.base_file = serialization_settings.file;
+	}
+
+	Array& base_requests = node.AsDict().at("base_requests"s).AsArray();
+	ReadBaseDeltaRequests(base_requests, delta);
+}
+
+void ReadSerializationSettings(const Dict& settings, SerializationSettings& serialization_settings) {
+
+	serialization_settings.file = settings.at("file"s).AsString();
+
+	if (auto it = settings.find("format"s); it != settings.end()) {
+
+		const string& format = it->second.AsString();
+
+		if (format == "protobuf"s) {
+			serialization_settings.format = BaseFormat::PROTOBUF;
+		}
+		else if (format == "mapped"s) {
+			serialization_settings.format = BaseFormat::MAPPED;
+		}
+		else {
+			throw invalid_argument("Unknown serialization format: "s + format);
+		}
+	}
+	if (auto it = settings.find("compression"s); it != settings.end()) {
+
+		const string& compression = it->second.AsString();
+
+		if (compression == "none"s) {
+			serialization_settings.compression = BaseCompression::NONE;
+		}
+		else if (compression == "zlib"s) {
+			serialization_settings.compression = BaseCompression::ZLIB;
+		}
+		else {
+			throw invalid_argument("Unknown serialization compression: "s + compression);
+		}
+	}
+	// The mapped base is used in place, so it is never compressed
+	if (serialization_settings.format == BaseFormat::MAPPED && serialization_settings.compression != BaseCompression::NONE) {
+		throw invalid_argument("The mapped base format does not support compression"s);
+	}
+}
+
+void ReadStatRequests(Array& stat_requests, Requests& requests);
+
+void ReadInput(std::istream& is, Requests& requests, std::filesystem::path& serialize_result_path) {
+
+	Node node = LoadNode(is);
+
+	serialize_result_path = node.AsDict().at("serialization_settings"s).AsDict().at("file"s).AsString();
+
+	Array& stat_requests = node.AsDict().at("stat_requests"s).AsArray();
+	ReadStatRequests(stat_requests, requests);
+}
+
+void ReadInput(std::istream& is, ServeSettings& settings) {
+
+	Node node = LoadNode(is);
+
+	settings.serialize_result_path = node.AsDict().at("serialization_settings"s).AsDict().at("file"s).AsString();
+
+	if (auto it = node.AsDict().find("serve_settings"s); it != node.AsDict().end()) {
+
+		const Dict& serve_settings = it->second.AsDict();
+
+		if (auto socket_it = serve_settings.find("socket"s); socket_it != serve_settings.end()) {
+			settings.socket_path = socket_it->second.AsString();
+		}
+		if (auto cache_it = serve_settings.find("route_cache_size_mb"s); cache_it != serve_settings.end()) {
+			const int cache_size_mb = cache_it->second.AsInt();
+			// 0 turns the cache off
+			if (cache_size_mb < 0 || static_cast<size_t>(cache_size_mb) > (numeric_limits<size_t>::max() >> 20)) {
+				throw invalid_argument("Invalid route_cache_size_mb: "s + to_string(cache_size_mb));
+			}
+			settings.route_cache_size = static_cast<size_t>(cache_size_mb) << 20;
+		}
+	}
+}
+
+void ReadStopDataRequest(json::Dict& request, serialize::StopData* stop_data);
+void ReadBusDataRequest(json::Dict& request, serialize::BusData* bus_data);
+
+void ReadBaseRequests(Array& base_requests, serialize::TransportCatalogue& serialize_transport) {
+
+	for (Node& node_request : base_requests) {
+
+		Dict& request = node_request.AsDict();
+
+		if (request.at("type"s) == "Stop"s) {
+			ReadStopDataRequest(request, serialize_transport.add_stops_data());
+		}
+		else if (request.at("type"s) == "Bus"s) {
+			ReadBusDataRequest(request, serialize_transport.add_buses_data());
+		}
+	}
+}
+
+// Same as the base requests of make_base; a request with "removed": true needs only the name
+void ReadBaseDeltaRequests(Array& base_requests, BaseDelta& delta) {
+
+	for (Node& node_request : base_requests) {
+
+		Dict& request = node_request.AsDict();
+
+		if (auto it = request.find("removed"s); it != request.end() && it->second.AsBool()) {
+
+			if (request.at("type"s) == "Stop"s) {
+				delta.removed_stops.push_back(move(request.at("name"s).AsString()));
+			}
+			else if (request.at("type"s) == "Bus"s) {
+				delta.removed_buses.push_back(move(request.at("name"s).AsString()));
+			}
+		}
+		else if (request.at("type"s) == "Stop"s) {
+			ReadStopDataRequest(request, delta.changes.add_stops_data());
+		}
+		else if (request.at("type"s) == "Bus"s) {
+			ReadBusDataRequest(request, delta.changes.add_buses_data());
+		}
+	}
+}
+
+void ReadJsonToPoint(const json::Node& point, serialize::Point& serialize_point);
+void ReadJsonToColor(json::Node& color, serialize::Color& serialize_color);
+
+void ReadRenderSettings(Dict& render_settings, serialize::RenderSettings& render_attrs) {
+
+	render_attrs.set_map_width(render_settings.at("width"s).AsDouble());
+	render_attrs.set_map_height(render_settings.at("height"s).AsDouble());
+	render_attrs.set_map_padding(render_settings.at("padding"s).AsDouble());
+	render_attrs.set_stop_radius(render_settings.at("stop_radius"s).AsDouble());
+	render_attrs.set_line_width(render_settings.at("line_width"s).AsDouble());
+	render_attrs.set_bus_label_font_size(static_cast<uint32_t>(render_settings.at("bus_label_font_size"s).AsInt()));
+	render_attrs.set_stop_label_font_size(static_cast<uint32_t>(render_settings.at("stop_label_font_size"s).AsInt()));
+	render_attrs.set_underlayer_width(render_settings.at("underlayer_width"s).AsDouble());
+
+	ReadJsonToPoint(render_settings.at("bus_label_offset"s), *render_attrs.mutable_bus_label_offset());
+	ReadJsonToPoint(render_settings.at("stop_label_offset"s), *render_attrs.mutable_stop_label_offset());
+	ReadJsonToColor(render_settings.at("underlayer_color"s), *render_attrs.mutable_underlayer_color());
+	
+	json::Array color_palette = render_settings.at("color_palette"s).AsArray();
+	for (json::Node& color : color_palette) {
+		ReadJsonToColor(color, *render_attrs.add_stroke_colors());
+	}
+}
+
+void ReadJsonToPoint(const json::Node& point, serialize::Point& serialize_point) {
+	json::Array coordinates = point.AsArray();
+	serialize_point.set_x(coordinates[0].AsDouble());
+	serialize_point.set_y(coordinates[1].AsDouble());
+}
+
+void ReadJsonToColor(json::Node& color, serialize::Color& serialize_color) {
+
+	if (color.IsString()) {
+		serialize_color.set_color_str(move(color.AsString()));
+	}
+	else {
+		uint8_t red = static_cast<uint8_t>(color.AsArray()[0].AsInt());
+		uint8_t green = static_cast<uint8_t>(color.AsArray()[1].AsInt());
+		uint8_t blue = static_cast<uint8_t>(color.AsArray()[2].AsInt());
+
+		serialize_color.set_red(red);
+		serialize_color.set_green(green);
+		serialize_color.set_blue(blue);
+
+		if (color.AsArray().size() == 4) {
+			double opacity = color.AsArray()[3].AsDouble();
+			serialize_color.mutable_opacity()->set_value(opacity);
+		}
+	}
+}
+
+void ReadStatRequests(Array& stat_requests, Requests& requests) {
+	for (Node& node_request : stat_requests) {
+
+		requests.Add(ReadStatRequest(node_request));
+	}
+}
+
+Request ReadStatRequest(Node& request) {
+
+	int id = request.AsDict().at("id"s).AsInt();
+	const string& type_request = request.AsDict().at("type"s).AsString();
+	TypeRequest type;
+
+	if (type_request == "Bus"s) {
+		type = TypeRequest::BUS;
+	}
+	else if (type_request == "Stop"s) {
+		type = TypeRequest::STOP;
+	}
+	else if (type_request == "Map"s) {
+		type = TypeRequest::MAP;
+	}
+	else if (type_request == "RouteMatrix"s) {
+		type = TypeRequest::ROUTE_MATRIX;
+	}
+	else {
+		type = TypeRequest::ROUTE;
+	}
+
+	string name;
+
+	if (type == TypeRequest::BUS || type == TypeRequest::STOP) {
+		name = move(request.AsDict().at("name"s).AsString());
+	}
+
+	RouteFinalStops final_stops;
+
+	if (type == TypeRequest::ROUTE) {
+		final_stops.from = move(request.AsDict().at("from"s).AsString());
+		final_stops.to = move(request.AsDict().at("to"s).AsString());
+	}
+
+	RouteMatrixStops matrix_stops;
+
+	if (type == TypeRequest::ROUTE_MATRIX) {
+		for (Node& stop_name : request.AsDict().at("from"s).AsArray()) {
+			matrix_stops.from.push_back(move(stop_name.AsString()));
+		}
+		for (Node& stop_name : request.AsDict().at("to"s).AsArray()) {
+			matrix_stops.to.push_back(move(stop_name.AsString()));
+		}
+		if (request.AsDict().count("itineraries"s)) {
+			matrix_stops.itineraries = request.AsDict().at("itineraries"s).AsBool();
+		}
+	}
+
+	return Request{ id , move(name), type, move(final_stops), move(matrix_stops) };
+}
+
+void ReadStopDataRequest(json::Dict& request, serialize::StopData* stop_data) {
+
+	stop_data->set_name(move(request.at("name"s).AsString()));
+	stop_data->set_latitude(request.at("latitude"s).AsDouble());
+	stop_data->set_longitude(request.at("longitude"s).AsDouble());
+
+	if (auto it = request.find("road_distances"s); it != request.end()) {
+
+		Dict& node_distances = it->second.AsDict();
+
+		for (auto& [stop_name, distance] : node_distances) {
+
+			if (distance.AsInt() < 0) {
+				throw invalid_argument("Negative road distance from "s + stop_data->name() + " to "s + stop_name);
+			}
+			auto road_distance = stop_data->add_road_distances();
+			road_distance->set_stop_name(move(stop_name));
+			road_distance->set_distance(distance.AsInt());
+		}
+	}
+}
+
+void ReadBusDataRequest(json::Dict& request, serialize::BusData* bus_data) {
+
+	bus_data->set_is_roundtrip(request.at("is_roundtrip"s).AsBool());
+	bus_data->set_name(move(request.at("name"s).AsString()));
+
+	for (Node& stop : request.at("stops"s).AsArray()) {
+
+		*bus_data->add_stops() = move(stop.AsString());
+	}
+}
+
+void ReadRoutingSettings(const Dict& routing_settings, serialize::RoutingSettings& routing_attrs) {
+
+	routing_attrs.set_bus_velocity(routing_settings.at("bus_velocity"s).AsDouble());
+	routing_attrs.set_bus_wait_time(static_cast<size_t>(routing_settings.at("bus_wait_time"s).AsInt()));
+
+	if (auto it = routing_settings.find("router_mode"s); it != routing_settings.end()) {
+
+		const string& router_mode = it->second.AsString();
+
+		if (router_mode == "precomputed"s) {
+			routing_attrs.set_router_mode(serialize::PRECOMPUTED);
+		}
+		else if (router_mode == "on_demand"s) {
+			routing_attrs.set_router_mode(serialize::ON_DEMAND);
+		}
+		else if (router_mode == "contracted"s) {
+			routing_attrs.set_router_mode(serialize::CONTRACTED);
+		}
+		else {
+			throw invalid_argument("Unknown router_mode: "s + router_mode);
+		}
+	}
+	if (auto it = routing_settings.find("graph_model"s); it != routing_settings.end()) {
+
+		const string& graph_model = it->second.AsString();
+
+		if (graph_model == "spans"s) {
+			routing_attrs.set_graph_model(serialize::SPANS);
+		}
+		else if (graph_model == "stop_bus"s) {
+			routing_attrs.set_graph_model(serialize::STOP_BUS);
+		}
+		else {
+			throw invalid_argument("Unknown graph_model: "s + graph_model);
+		}
+	}
 }
\ No newline at end of file
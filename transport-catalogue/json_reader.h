@@ -1,50 +1,76 @@
-#pragma once
-
-#include "transport_catalogue.h"
-#include "map_renderer.h"
-#include "transport_router.h"
-#include "serialization.h"
-
-#include <istream>
-#include <vector>
-#include <transport_catalogue.pb.h>
-#include <filesystem>
-
-enum class TypeRequest {
-	BUS,
-	STOP,
-	MAP,
-	ROUTE
-};
-
-struct RouteFinalStops {
-	std::string from;
-	std::string to;
-};
-
-struct Request {
-	int id;
-	std::string name;
-	TypeRequest type;
-	RouteFinalStops route_final_stops;
-};
-
-class Requests {
-public:
-	void Add(Request&& request);
-	void SetRouteRequestPresence();
-	bool IsRouteRequestPresence() const;
-
-	std::vector<Request>::iterator begin();
-	std::vector<Request>::iterator end();
-	std::vector<Request>::const_iterator begin() const;
-	std::vector<Request>::const_iterator end() const;
-private:
-	std::vector<Request> requests_;
-	bool has_route_request_ = false;
-};
-
-void ReadInput(	std::istream& is, serialize::TransportCatalogue& serialize_transport,
-				std::filesystem::path& serialize_result_path);
-
-void ReadInput(std::istream& is, Requests& requests, std::filesystem::path& serialize_result_path);
\ No newline at end of file
+#pragma once
+
+#include "transport_catalogue.h"
+#include "map_renderer.h"
+#include "transport_router.h"
+#include "serialization.h"
+
+#include <istream>
+#include <vector>
+#include <transport_catalogue.pb.h>
+#include <filesystem>
+#include <optional>
+
+enum class TypeRequest {
+	BUS,
+	STOP,
+	MAP,
+	ROUTE,
+	ROUTE_MATRIX
+};
+
+struct RouteFinalStops {
+	std::string from;
+	std::string to;
+};
+
+// Every stop of from to every stop of to
+struct RouteMatrixStops {
+	std::vector<std::string> from;
+	std::vector<std::string> to;
+	bool itineraries = false; // items of every route, not only the total times
+};
+
+struct Request {
+	int id;
+	std::string name;
+	TypeRequest type;
+	RouteFinalStops route_final_stops;
+	RouteMatrixStops route_matrix_stops;
+};
+
+class Requests {
+public:
+	void Add(Request&& request);
+	bool IsRouteRequestPresence() const;
+
+	// Only what the added requests need
+	const BaseParts& GetBaseParts() const;
+
+	std::vector<Request>::iterator begin();
+	std::vector<Request>::iterator end();
+	std::vector<Request>::const_iterator begin() const;
+	std::vector<Request>::const_iterator end() const;
+private:
+	std::vector<Request> requests_;
+	BaseParts base_parts_{ false, false, false, false, false };
+};
+
+struct ServeSettings {
+	std::filesystem::path serialize_result_path;
+	std::optional<std::filesystem::path> socket_path; // stat requests come from the input stream if not set
+	// bytes; 0 - no cache of on-demand route searches. Its statistics are printed to std::cerr
+	// when the input stream is served; a socket server runs until killed and never prints them.
+	size_t route_cache_size = 0;
+};
+
+void ReadInput(	std::istream& is, serialize::TransportCatalogue& serialize_transport,
+				SerializationSettings& serialization_settings);
+
+void ReadInput(std::istream& is, Requests& requests, std::filesystem::path& serialize_result_path);
+
+void ReadInput(std::istream& is, ServeSettings& settings);
+
+void ReadInput(std::istream& is, BaseDelta& delta, SerializationSettings& serialization_settings);
+
+Request ReadStatRequest(json::Node& request);
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "map_renderer.h"
 #include "serialization.h"
 #include "transport_router.h"
+#include "query_server.h"
 
 #include <transport_catalogue.pb.h>
 #include <fstream>
@@ -11,11 +12,12 @@
 #include <string_view>
 #include <filesystem>
 #include <optional>
+#include <stdexcept>
 
 using namespace std;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-	stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+	stream << "Usage: transport_catalogue [make_base|update_base|process_requests|serve]\n"sv;
 }
 
 int main(int argc, char* argv[]) {
@@ -31,14 +33,39 @@ int main(int argc, char* argv[]) {
 	if (mode == "make_base"sv) {
 
 		serialize::TransportCatalogue serialize_transport;
-		ReadInput(cin, serialize_transport, serialize_result_path);
+		SerializationSettings serialization_settings;
+		try {
+			ReadInput(cin, serialize_transport, serialization_settings);
+		}
+		catch (const invalid_argument& e) {
+			std::cerr << e.what() << '\n';
+			return 1;
+		}
 		
-		if (!SerializeTransportCatalogue(serialize_transport, serialize_result_path)) {
+		if (!SerializeTransportCatalogue(serialize_transport, serialization_settings)) {
 
 			std::cerr << "Serialization error\n";
 			return 1;
 		}
 	} 
+	else if (mode == "update_base"sv) {
+
+		BaseDelta delta;
+		SerializationSettings serialization_settings;
+		try {
+			ReadInput(cin, delta, serialization_settings);
+		}
+		catch (const invalid_argument& e) {
+			std::cerr << e.what() << '\n';
+			return 1;
+		}
+
+		if (!UpdateTransportCatalogue(delta, serialization_settings)) {
+
+			std::cerr << "Serialization error\n";
+			return 1;
+		}
+	}
 	else if (mode == "process_requests"sv) {
 
 		Requests requests;
@@ -48,13 +75,60 @@ int main(int argc, char* argv[]) {
 		InputAttrs attrs;
 		optional<routing::TransportRouter> router;
 
-		if (!DeserializeTransportCatalogue(serialize_result_path, transport, attrs, router, requests.IsRouteRequestPresence())) {
+		if (!DeserializeTransportCatalogue(serialize_result_path, transport, attrs, router, requests.GetBaseParts())) {
 
 			std::cerr << "Deserialization error\n";
 			return 1;
 		}
-		RequestHandler{ transport, requests, attrs, router }.ProcessRequests(cout);
+		// A mapped routes table is checked row by row as the routes are built
+		try {
+			RequestHandler{ transport, attrs, router }.ProcessRequests(requests, cout);
+		}
+		catch (const invalid_argument& e) {
+			std::cerr << e.what() << '\n';
+			return 1;
+		}
 	} 
+	else if (mode == "serve"sv) {
+
+		ServeSettings settings;
+		try {
+			ReadInput(cin, settings);
+		}
+		catch (const invalid_argument& e) {
+			std::cerr << e.what() << '\n';
+			return 1;
+		}
+
+		transport::TransportCatalogue transport;
+		InputAttrs attrs;
+		optional<routing::TransportRouter> router;
+
+		if (!DeserializeTransportCatalogue(settings.serialize_result_path, transport, attrs, router, BaseParts{})) {
+
+			std::cerr << "Deserialization error\n";
+			return 1;
+		}
+		if (router && settings.route_cache_size != 0) {
+			router->EnableRouteCache(settings.route_cache_size);
+		}
+		RequestHandler request_handler{ transport, attrs, router };
+		QueryServer server{ request_handler };
+
+		if (!settings.socket_path) {
+			server.Serve(cin, cout);
+			// A socket server runs until it is killed, so only the input stream mode reports the cache
+			if (const auto stats = router ? router->GetRouteCacheStats() : nullopt) {
+				std::cerr << "Route cache: "sv << stats->hits << " hits, "sv << stats->misses << " misses, "sv
+					<< stats->tree_count << " trees, "sv << stats->memory_size << " bytes\n"sv;
+			}
+		}
+		else if (!server.ServeUnixSocket(*settings.socket_path)) {
+
+			std::cerr << "Socket error\n";
+			return 1;
+		}
+	}
 	else {
 		PrintUsage();
 		return 1;
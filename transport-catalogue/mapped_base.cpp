@@ -0,0 +1,669 @@
+#include "mapped_base.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+#include "checksum.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TRANSPORT_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace routing;
+
+namespace {
+
+constexpr char MAGIC[8] = { 'T', 'C', 'M', 'A', 'P', 'P', 'E', 'D' };
+constexpr uint32_t VERSION = 6;
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+constexpr uint64_t ALIGNMENT = 8;
+
+struct Section {
+	uint64_t offset = 0;
+	uint64_t size = 0; // bytes
+	uint64_t checksum = 0; // see checksum.h
+};
+
+struct Header {
+	char magic[8] = {};
+	uint32_t version = VERSION;
+	uint32_t byte_order = BYTE_ORDER_MARK;
+	uint32_t stop_count = 0;
+	uint32_t bus_count = 0;
+	uint32_t vertex_count = 0; // transport graph, stop vertices first
+	uint32_t has_routes = 0; // 0 - no routes table
+	uint32_t router_mode = 0; // 0 - precomputed, 1 - on demand, 2 - contracted
+	uint32_t graph_model = 0; // 0 - spans, 1 - stop-bus
+	double bus_velocity = 0.;
+	uint64_t bus_wait_time = 0;
+	uint64_t file_size = 0; // a truncated or extended file is rejected before its sections are read
+	Section names; // all stop and bus names one after another
+	Section stops;
+	Section distances;
+	Section buses;
+	Section paths;
+	Section render_settings; // serialize::RenderSettings message
+	Section edges; // in edge id order
+	Section route_weights; // the two routes table sections are checked row by row, see route_row_checksums
+	Section route_prev_edges;
+	Section route_row_checksums; // per row: its weights and prev edges, as RouteRowChecksum computes it
+	Section vertex_ranks; // contraction hierarchy, uint32 per vertex
+	Section shortcuts;
+};
+
+struct MappedStop {
+	double latitude = 0.;
+	double longitude = 0.;
+	uint64_t name_offset = 0;
+	uint32_t name_size = 0;
+	uint32_t is_defined = 0; // 0 - the name is only referenced
+};
+
+struct MappedDistance {
+	uint32_t stop_from = 0;
+	uint32_t stop_to = 0;
+	uint32_t distance = 0;
+};
+
+struct MappedEdge {
+	uint32_t vertex_from = 0;
+	uint32_t vertex_to = 0;
+	uint32_t bus_id = 0;
+	uint32_t span_count = 0;
+	double weight = 0.;
+};
+
+struct MappedShortcut {
+	uint32_t vertex_from = 0;
+	uint32_t vertex_to = 0;
+	uint32_t first_edge = 0;
+	uint32_t second_edge = 0;
+	double weight = 0.;
+};
+
+struct MappedBus {
+	uint64_t name_offset = 0;
+	uint32_t name_size = 0;
+	uint32_t is_ring = 0;
+	uint64_t path_offset = 0; // stops
+	uint64_t path_size = 0;
+	uint64_t stop_count = 0;
+	uint64_t unique_stop_count = 0;
+	uint64_t route_length = 0;
+	double geo_length = 0.;
+};
+
+static_assert(is_trivially_copyable_v<Header> && is_trivially_copyable_v<MappedStop>
+			  && is_trivially_copyable_v<MappedDistance> && is_trivially_copyable_v<MappedBus>
+			  && is_trivially_copyable_v<MappedEdge> && is_trivially_copyable_v<MappedShortcut>);
+
+// Read-only view of a whole file; mapped where the platform allows, read into memory otherwise
+class MappedFile {
+public:
+	explicit MappedFile(const filesystem::path& path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool IsOpen() const;
+	const char* GetData() const;
+	size_t GetSize() const;
+
+	// Turns off read-ahead for the section, so only the touched pages are read from disk
+	void AdviseRandomAccess(const Section& section) const;
+
+private:
+	bool is_open_ = false;
+	const char* data_ = nullptr;
+	size_t size_ = 0;
+#ifdef TRANSPORT_MMAP
+	void* mapping_ = nullptr;
+#else
+	vector<char> buffer_;
+#endif
+};
+
+#ifdef TRANSPORT_MMAP
+
+MappedFile::MappedFile(const filesystem::path& path) {
+	const int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return;
+	}
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) == 0) {
+		size_ = static_cast<size_t>(file_stat.st_size);
+		if (size_ == 0) {
+			is_open_ = true;
+		}
+		else if (void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0); mapping != MAP_FAILED) {
+			mapping_ = mapping;
+			data_ = static_cast<const char*>(mapping);
+			is_open_ = true;
+		}
+	}
+	close(fd);
+}
+
+MappedFile::~MappedFile() {
+	if (mapping_) {
+		munmap(mapping_, size_);
+	}
+}
+
+void MappedFile::AdviseRandomAccess(const Section& section) const {
+	if (!mapping_ || section.size == 0) {
+		return;
+	}
+	const uint64_t page_size = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+	const uint64_t begin = section.offset / page_size * page_size;
+	madvise(static_cast<char*>(mapping_) + begin, section.offset + section.size - begin, MADV_RANDOM);
+}
+
+#else
+
+MappedFile::MappedFile(const filesystem::path& path) {
+	ifstream ifs{ path, ios::binary | ios::ate };
+	if (!ifs) {
+		return;
+	}
+	buffer_.resize(static_cast<size_t>(ifs.tellg()));
+	ifs.seekg(0);
+	if (ifs.read(buffer_.data(), buffer_.size())) {
+		data_ = buffer_.data();
+		size_ = buffer_.size();
+		is_open_ = true;
+	}
+}
+
+MappedFile::~MappedFile() = default;
+
+void MappedFile::AdviseRandomAccess(const Section&) const {
+}
+
+#endif
+
+bool MappedFile::IsOpen() const {
+	return is_open_;
+}
+
+const char* MappedFile::GetData() const {
+	return data_;
+}
+
+size_t MappedFile::GetSize() const {
+	return size_;
+}
+
+uint64_t AlignUp(uint64_t offset) {
+	return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+// Checksum of the vertex_count cells of a routes table row
+uint64_t RouteRowChecksum(const double* weights, const TransportRoutesData::PrevEdge* prev_edges, size_t vertex_count) {
+	return CombineChecksums({ ComputeChecksum(weights, vertex_count * sizeof(double)),
+							  ComputeChecksum(prev_edges, vertex_count * sizeof(TransportRoutesData::PrevEdge)) });
+}
+
+// Places a section of size bytes after the previous ones
+Section PlaceSection(uint64_t& file_size, uint64_t size) {
+	Section section{ AlignUp(file_size), size, 0 };
+	file_size = section.offset + section.size;
+	return section;
+}
+
+void WriteSection(ofstream& ofs, uint64_t& position, const Section& section, const void* data) {
+	static const char padding[ALIGNMENT] = {};
+	ofs.write(padding, static_cast<streamsize>(section.offset - position));
+	ofs.write(static_cast<const char*>(data), static_cast<streamsize>(section.size));
+	position = section.offset + section.size;
+}
+
+// nullptr if the section does not hold whole elements of T inside the file
+template <typename T>
+const T* GetSectionData(const MappedFile& file, const Section& section) {
+	if (section.offset > file.GetSize() || section.size > file.GetSize() - section.offset
+		|| section.offset % alignof(T) != 0 || section.size % sizeof(T) != 0) {
+		return nullptr;
+	}
+	return reinterpret_cast<const T*>(file.GetData() + section.offset);
+}
+
+bool ReadMappedDistances(const MappedFile& file, const Header& header, transport::TransportCatalogue& transport) {
+
+	const MappedDistance* distances = GetSectionData<MappedDistance>(file, header.distances);
+
+	if (!distances) {
+		return false;
+	}
+	const size_t distance_count = header.distances.size / sizeof(MappedDistance);
+
+	for (size_t index = 0; index < distance_count; ++index) {
+
+		const MappedDistance& distance = distances[index];
+
+		if (distance.stop_from >= header.stop_count || distance.stop_to >= header.stop_count) {
+			return false;
+		}
+		transport.SetDistance(distance.stop_from, distance.stop_to, distance.distance);
+	}
+	return true;
+}
+
+// Checks the sections the parts are read from, on worker threads. The routes table is
+// used in place and only the row checksums are checked here; a row is checked against
+// its checksum on its first query, so that only the queried rows are ever paged in.
+bool VerifySections(const MappedFile& file, const Header& header, const BaseParts& parts) {
+
+	vector<const Section*> sections{ &header.names, &header.stops, &header.buses };
+
+	if (parts.road_distances) {
+		sections.push_back(&header.distances);
+	}
+	if (parts.bus_paths) {
+		sections.push_back(&header.paths);
+	}
+	if (parts.render_settings) {
+		sections.push_back(&header.render_settings);
+	}
+	if (parts.routes) {
+		sections.push_back(&header.edges);
+		sections.push_back(&header.route_row_checksums);
+		sections.push_back(&header.vertex_ranks);
+		sections.push_back(&header.shortcuts);
+	}
+	vector<ChecksumRange> ranges;
+
+	for (const Section* section : sections) {
+
+		const char* data = GetSectionData<char>(file, *section);
+
+		if (!data) {
+			return false;
+		}
+		ranges.push_back(ChecksumRange{ data, section->size });
+	}
+	const vector<uint64_t> checksums = ComputeSectionChecksums(ranges);
+
+	for (size_t index = 0; index < sections.size(); ++index) {
+		if (checksums[index] != sections[index]->checksum) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// The routes table stays in the mapping; the pages of a row are read on its first query
+bool ReadMappedRoutes(const shared_ptr<const MappedFile>& file, const Header& header,
+					  const transport::TransportCatalogue& transport, const routing::Attrs& routing_attrs,
+					  optional<TransportRouter>& router) {
+
+	const MappedEdge* edges = GetSectionData<MappedEdge>(*file, header.edges);
+
+	if (!edges) {
+		return false;
+	}
+	const size_t edge_count = header.edges.size / sizeof(MappedEdge);
+	vector<TransportEdge> graph_edges(edge_count);
+	vector<EdgeInfo> edge_infos(edge_count);
+
+	for (graph::EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+
+		const MappedEdge& edge = edges[edge_id];
+
+		if (edge.bus_id >= header.bus_count) {
+			return false;
+		}
+		graph_edges[edge_id] = TransportEdge{ edge.vertex_from, edge.vertex_to, edge.weight };
+		edge_infos[edge_id] = EdgeInfo{ edge.bus_id, static_cast<int>(edge.span_count) };
+	}
+	TransportGraph graph{ header.vertex_count, move(graph_edges) };
+	optional<TransportRoutesData> routes_data;
+
+	if (routing_attrs.router_mode == RouterMode::PRECOMPUTED) {
+
+		const size_t vertex_count = header.vertex_count;
+		const size_t cell_count = vertex_count * vertex_count;
+		const double* weights = GetSectionData<double>(*file, header.route_weights);
+		const auto* prev_edges = GetSectionData<TransportRoutesData::PrevEdge>(*file, header.route_prev_edges);
+		const uint64_t* row_checksums = GetSectionData<uint64_t>(*file, header.route_row_checksums);
+
+		if (!header.has_routes || !weights || !prev_edges || !row_checksums
+			|| header.route_weights.size != cell_count * sizeof(double)
+			|| header.route_prev_edges.size != cell_count * sizeof(TransportRoutesData::PrevEdge)
+			|| header.route_row_checksums.size != vertex_count * sizeof(uint64_t)) {
+			return false;
+		}
+		file->AdviseRandomAccess(header.route_weights);
+		file->AdviseRandomAccess(header.route_prev_edges);
+
+		// A row is used only if it is the one written and refers to edges of the graph
+		auto check_row = [row_checksums, vertex_count, edge_count](graph::VertexId from, const double* row_weights,
+																   const TransportRoutesData::PrevEdge* row_prev_edges) {
+			if (RouteRowChecksum(row_weights, row_prev_edges, vertex_count) != row_checksums[from]) {
+				return false;
+			}
+			return all_of(row_prev_edges, row_prev_edges + vertex_count, [edge_count](TransportRoutesData::PrevEdge prev_edge) {
+				return prev_edge < edge_count || prev_edge == TransportRoutesData::NO_EDGE
+					|| prev_edge == TransportRoutesData::UNREACHABLE;
+			});
+		};
+		routes_data.emplace(vertex_count, weights, prev_edges, file, move(check_row));
+	}
+
+	optional<TransportHierarchy> hierarchy;
+
+	// The hierarchy is small next to the graph and is bulk-loaded; its ids are checked by the router
+	if (routing_attrs.router_mode == RouterMode::CONTRACTED) {
+
+		const uint32_t* vertex_ranks = GetSectionData<uint32_t>(*file, header.vertex_ranks);
+		const MappedShortcut* shortcuts = GetSectionData<MappedShortcut>(*file, header.shortcuts);
+
+		if (!vertex_ranks || !shortcuts || header.vertex_ranks.size != header.vertex_count * sizeof(uint32_t)) {
+			return false;
+		}
+		hierarchy.emplace();
+		hierarchy->ranks.assign(vertex_ranks, vertex_ranks + header.vertex_count);
+		hierarchy->shortcuts.reserve(header.shortcuts.size / sizeof(MappedShortcut));
+
+		for (const MappedShortcut* shortcut = shortcuts; shortcut != shortcuts + header.shortcuts.size / sizeof(MappedShortcut);
+			 ++shortcut) {
+			hierarchy->shortcuts.push_back({ shortcut->vertex_from, shortcut->vertex_to, shortcut->weight,
+											 shortcut->first_edge, shortcut->second_edge });
+		}
+	}
+	router.emplace(transport, routing_attrs, move(graph), move(edge_infos), move(routes_data), move(hierarchy));
+	return true;
+}
+
+} // namespace
+
+bool WriteMappedBase(const transport::TransportCatalogue& transport, const routing::Attrs& routing_attrs,
+					 const serialize::RenderSettings& render_settings, const TransportRouter& transport_router,
+					 const TransportRoutesData* routes_data, const TransportHierarchy* hierarchy,
+					 const filesystem::path& path) {
+
+	const size_t stop_count = transport.GetStopsCount();
+	const size_t bus_count = transport.GetBusesCount();
+
+	string names;
+	vector<MappedStop> stops(stop_count);
+	vector<MappedBus> buses(bus_count);
+	vector<MappedDistance> distances;
+	vector<transport::StopId> paths;
+
+	for (transport::StopId stop_id = 0; stop_id < stop_count; ++stop_id) {
+
+		MappedStop& stop = stops[stop_id];
+		const string_view name = transport.GetStopName(stop_id);
+		stop.name_offset = names.size();
+		stop.name_size = static_cast<uint32_t>(name.size());
+		names += name;
+
+		if (const transport::StopData* stop_data = transport.GetStopData(stop_id)) {
+			stop.latitude = stop_data->GetCoordinates().lat;
+			stop.longitude = stop_data->GetCoordinates().lng;
+			stop.is_defined = 1;
+		}
+	}
+
+	transport.GetDistances().ForEachExplicit([&distances](transport::StopId from, transport::StopId to, size_t distance) {
+		distances.push_back(MappedDistance{ from, to, static_cast<uint32_t>(distance) });
+	});
+
+	for (transport::BusId bus_id = 0; bus_id < bus_count; ++bus_id) {
+
+		MappedBus& bus = buses[bus_id];
+		const string_view name = transport.GetBusName(bus_id);
+		bus.name_offset = names.size();
+		bus.name_size = static_cast<uint32_t>(name.size());
+		names += name;
+
+		const transport::BusData& bus_data = transport.GetBusData(bus_id);
+		const transport::PathView path = transport.GetBusPath(bus_id);
+		bus.is_ring = bus_data.IsRing() ? 1 : 0;
+		bus.path_offset = paths.size();
+		bus.path_size = path.size();
+		paths.insert(paths.end(), path.begin(), path.end());
+
+		const transport::BusStats& stats = bus_data.GetStats();
+		bus.stop_count = stats.stop_count;
+		bus.unique_stop_count = stats.unique_stop_count;
+		bus.route_length = stats.route_length;
+		bus.geo_length = stats.geo_length;
+	}
+
+	const TransportGraph& graph = transport_router.GetGraph();
+	vector<MappedEdge> edges(graph.GetEdgeCount());
+
+	for (graph::EdgeId edge_id = 0; edge_id < edges.size(); ++edge_id) {
+
+		const TransportEdge& edge = graph.GetEdge(edge_id);
+		const EdgeInfo& edge_info = transport_router.GetEdgeInfo(edge_id);
+		edges[edge_id] = MappedEdge{ static_cast<uint32_t>(edge.from), static_cast<uint32_t>(edge.to), edge_info.bus_id,
+									 static_cast<uint32_t>(edge_info.span_count), edge.weight };
+	}
+
+	vector<uint32_t> vertex_ranks;
+	vector<MappedShortcut> shortcuts;
+
+	if (hierarchy) {
+		vertex_ranks.assign(hierarchy->ranks.begin(), hierarchy->ranks.end());
+
+		for (const auto& shortcut : hierarchy->shortcuts) {
+			shortcuts.push_back(MappedShortcut{ static_cast<uint32_t>(shortcut.from), static_cast<uint32_t>(shortcut.to),
+												static_cast<uint32_t>(shortcut.first_edge),
+												static_cast<uint32_t>(shortcut.second_edge), shortcut.weight });
+		}
+	}
+
+	const string render_settings_data = render_settings.SerializeAsString();
+	const size_t route_row_count = routes_data ? routes_data->GetVertexCount() : 0;
+	const size_t cell_count = route_row_count * route_row_count;
+	vector<uint64_t> route_row_checksums(route_row_count);
+
+	ParallelFor(route_row_count, [routes_data, route_row_count, &route_row_checksums](size_t row) {
+		route_row_checksums[row] = RouteRowChecksum(routes_data->GetWeights() + row * route_row_count,
+													routes_data->GetPrevEdges() + row * route_row_count, route_row_count);
+	});
+
+	Header header;
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.stop_count = static_cast<uint32_t>(stop_count);
+	header.bus_count = static_cast<uint32_t>(bus_count);
+	header.vertex_count = static_cast<uint32_t>(graph.GetVertexCount());
+	header.has_routes = routes_data ? 1 : 0;
+	header.router_mode = routing_attrs.router_mode == RouterMode::ON_DEMAND ? 1
+		: routing_attrs.router_mode == RouterMode::CONTRACTED ? 2 : 0;
+	header.graph_model = routing_attrs.graph_model == GraphModel::STOP_BUS ? 1 : 0;
+	header.bus_velocity = routing_attrs.bus_velocity;
+	header.bus_wait_time = routing_attrs.bus_wait_time;
+
+	uint64_t file_size = sizeof(Header);
+	header.names = PlaceSection(file_size, names.size());
+	header.stops = PlaceSection(file_size, stops.size() * sizeof(MappedStop));
+	header.distances = PlaceSection(file_size, distances.size() * sizeof(MappedDistance));
+	header.buses = PlaceSection(file_size, buses.size() * sizeof(MappedBus));
+	header.paths = PlaceSection(file_size, paths.size() * sizeof(transport::StopId));
+	header.render_settings = PlaceSection(file_size, render_settings_data.size());
+	header.edges = PlaceSection(file_size, edges.size() * sizeof(MappedEdge));
+	header.route_weights = PlaceSection(file_size, cell_count * sizeof(double));
+	header.route_prev_edges = PlaceSection(file_size, cell_count * sizeof(TransportRoutesData::PrevEdge));
+	header.route_row_checksums = PlaceSection(file_size, route_row_checksums.size() * sizeof(uint64_t));
+	header.vertex_ranks = PlaceSection(file_size, vertex_ranks.size() * sizeof(uint32_t));
+	header.shortcuts = PlaceSection(file_size, shortcuts.size() * sizeof(MappedShortcut));
+	header.file_size = file_size;
+
+	vector<pair<Section*, const void*>> sections{
+		{ &header.names, names.data() }, { &header.stops, stops.data() }, { &header.distances, distances.data() },
+		{ &header.buses, buses.data() }, { &header.paths, paths.data() },
+		{ &header.render_settings, render_settings_data.data() }, { &header.edges, edges.data() },
+		{ &header.route_row_checksums, route_row_checksums.data() }, { &header.vertex_ranks, vertex_ranks.data() },
+		{ &header.shortcuts, shortcuts.data() } };
+	vector<ChecksumRange> ranges;
+
+	for (const auto& [section, data] : sections) {
+		ranges.push_back(ChecksumRange{ data, section->size });
+	}
+	const vector<uint64_t> checksums = ComputeSectionChecksums(ranges);
+
+	for (size_t index = 0; index < sections.size(); ++index) {
+		sections[index].first->checksum = checksums[index];
+	}
+
+	ofstream ofs{ path, ios::binary };
+	uint64_t position = 0;
+
+	WriteSection(ofs, position, Section{ 0, sizeof(Header), 0 }, &header);
+	WriteSection(ofs, position, header.names, names.data());
+	WriteSection(ofs, position, header.stops, stops.data());
+	WriteSection(ofs, position, header.distances, distances.data());
+	WriteSection(ofs, position, header.buses, buses.data());
+	WriteSection(ofs, position, header.paths, paths.data());
+	WriteSection(ofs, position, header.render_settings, render_settings_data.data());
+	WriteSection(ofs, position, header.edges, edges.data());
+
+	if (routes_data) {
+		WriteSection(ofs, position, header.route_weights, routes_data->GetWeights());
+		WriteSection(ofs, position, header.route_prev_edges, routes_data->GetPrevEdges());
+	}
+	WriteSection(ofs, position, header.route_row_checksums, route_row_checksums.data());
+	WriteSection(ofs, position, header.vertex_ranks, vertex_ranks.data());
+	WriteSection(ofs, position, header.shortcuts, shortcuts.data());
+	return static_cast<bool>(ofs);
+}
+
+bool IsMappedBase(const filesystem::path& path) {
+
+	char magic[sizeof(MAGIC)] = {};
+	ifstream ifs{ path, ios::binary };
+
+	return ifs.read(magic, sizeof(magic)) && memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+bool ReadMappedBase(const filesystem::path& path, transport::TransportCatalogue& transport,
+					InputAttrs& attrs, optional<TransportRouter>& router,
+					const BaseParts& parts) {
+
+	const auto file = make_shared<const MappedFile>(path);
+
+	if (!file->IsOpen() || file->GetSize() < sizeof(Header)) {
+		return false;
+	}
+	Header header;
+	memcpy(&header, file->GetData(), sizeof(Header));
+
+	if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION
+		|| header.byte_order != BYTE_ORDER_MARK || header.file_size != file->GetSize()
+		|| !VerifySections(*file, header, parts)) {
+		return false;
+	}
+
+	const char* names = GetSectionData<char>(*file, header.names);
+	const MappedStop* stops = GetSectionData<MappedStop>(*file, header.stops);
+	const MappedBus* buses = GetSectionData<MappedBus>(*file, header.buses);
+
+	if (!names || !stops || !buses
+		|| header.stops.size / sizeof(MappedStop) != header.stop_count
+		|| header.buses.size / sizeof(MappedBus) != header.bus_count) {
+		return false;
+	}
+
+	auto get_name = [&header, names](uint64_t offset, uint32_t size) -> optional<string_view> {
+		if (offset > header.names.size || size > header.names.size - offset) {
+			return nullopt;
+		}
+		return string_view{ names + offset, size };
+	};
+
+	for (transport::StopId stop_id = 0; stop_id < header.stop_count; ++stop_id) {
+
+		const MappedStop& stop = stops[stop_id];
+		const optional<string_view> name = get_name(stop.name_offset, stop.name_size);
+
+		if (!name || transport.AddStopName(*name) != stop_id) {
+			return false;
+		}
+		if (parts.stops && stop.is_defined) {
+			transport.AddStop(*name, transport::StopData{ geo::Coordinates{ stop.latitude, stop.longitude } });
+		}
+	}
+
+	if (parts.road_distances && !ReadMappedDistances(*file, header, transport)) {
+		return false;
+	}
+
+	const transport::StopId* paths = GetSectionData<transport::StopId>(*file, header.paths);
+	const size_t path_arena_size = header.paths.size / sizeof(transport::StopId);
+
+	if (parts.bus_paths && !paths) {
+		return false;
+	}
+
+	for (transport::BusId bus_id = 0; bus_id < header.bus_count; ++bus_id) {
+
+		const MappedBus& bus = buses[bus_id];
+		const optional<string_view> name = get_name(bus.name_offset, bus.name_size);
+
+		if (!name) {
+			return false;
+		}
+		vector<transport::StopId> bus_path;
+
+		if (parts.bus_paths) {
+
+			if (bus.path_offset > path_arena_size || bus.path_size > path_arena_size - bus.path_offset) {
+				return false;
+			}
+			bus_path.assign(paths + bus.path_offset, paths + bus.path_offset + bus.path_size);
+
+			for (transport::StopId stop_id : bus_path) {
+				if (stop_id >= header.stop_count) {
+					return false;
+				}
+			}
+		}
+		if (transport.AddBus(string(*name), move(bus_path), bus.is_ring != 0) != bus_id) {
+			return false;
+		}
+		transport.SetBusStats(bus_id, transport::BusStats{ bus.stop_count, bus.unique_stop_count,
+														   bus.route_length, bus.geo_length });
+	}
+
+	if (parts.render_settings) {
+
+		const char* render_settings_data = GetSectionData<char>(*file, header.render_settings);
+		serialize::RenderSettings render_settings;
+
+		if (!render_settings_data
+			|| !render_settings.ParseFromArray(render_settings_data, static_cast<int>(header.render_settings.size))) {
+			return false;
+		}
+		ReadRenderSettings(render_settings, attrs.render_attrs);
+	}
+
+	attrs.routing_attrs.bus_velocity = header.bus_velocity;
+	attrs.routing_attrs.bus_wait_time = header.bus_wait_time;
+	attrs.routing_attrs.router_mode = header.router_mode == 1 ? RouterMode::ON_DEMAND
+		: header.router_mode == 2 ? RouterMode::CONTRACTED : RouterMode::PRECOMPUTED;
+	attrs.routing_attrs.graph_model = header.graph_model == 1 ? GraphModel::STOP_BUS : GraphModel::SPANS;
+
+	if (parts.routes) {
+		return ReadMappedRoutes(file, header, transport, attrs.routing_attrs, router);
+	}
+	return true;
+}
\ No newline at end of file
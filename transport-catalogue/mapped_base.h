@@ -0,0 +1,31 @@
+#pragma once
+
+#include "transport_catalogue.h"
+#include "transport_router.h"
+#include "serialization.h"
+
+#include <map_renderer.pb.h>
+#include <filesystem>
+#include <optional>
+
+// Flat binary base: a fixed header followed by 8-byte aligned sections which hold
+// the catalogue arrays in their in-memory layout (native byte order). The file is
+// mapped read-only; the routes table is used in place without copying or parsing,
+// the other sections, including the transport graph, are bulk-loaded. Only the
+// sections of the requested parts are read, so the pages of the others are never
+// touched, and only the routes table rows of the requested sources are paged in.
+// The header holds the file size and a checksum per section; the sections which are
+// read are checked before use, except for the routes table, whose rows are checked
+// against their own checksums on their first query.
+
+bool WriteMappedBase(const transport::TransportCatalogue& transport, const routing::Attrs& routing_attrs,
+					 const serialize::RenderSettings& render_settings, const routing::TransportRouter& transport_router,
+					 const routing::TransportRoutesData* routes_data, // nullptr - no precomputed routes
+					 const routing::TransportHierarchy* hierarchy, // nullptr - no contraction hierarchy
+					 const std::filesystem::path& path);
+
+bool IsMappedBase(const std::filesystem::path& path);
+
+bool ReadMappedBase(const std::filesystem::path& path, transport::TransportCatalogue& transport,
+					InputAttrs& attrs, std::optional<routing::TransportRouter>& router,
+					const BaseParts& parts);
\ No newline at end of file
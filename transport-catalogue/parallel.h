@@ -0,0 +1,30 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Runs function(index) for every index in [0, count) on up to hardware_concurrency threads
+template <typename Function>
+void ParallelFor(size_t count, Function function) {
+
+	const size_t thread_count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), count);
+	std::atomic<size_t> next_index = 0;
+
+	auto run = [&next_index, &function, count]() {
+		for (size_t index = next_index++; index < count; index = next_index++) {
+			function(index);
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (size_t thread_index = 1; thread_index < thread_count; ++thread_index) {
+		workers.emplace_back(run);
+	}
+	run();
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
\ No newline at end of file
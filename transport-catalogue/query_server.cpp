@@ -0,0 +1,210 @@
+#include "query_server.h"
+#include "json.h"
+#include "json_reader.h"
+#include "json_builder.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <iomanip>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define TRANSPORT_UNIX_SOCKETS
+#endif
+
+using namespace std;
+
+namespace {
+
+constexpr size_t MAX_CONNECTIONS = 64; // served at once; further clients wait in the listen backlog
+constexpr size_t MAX_LINE_SIZE = 1 << 20; // a longer request line closes its connection
+
+} // namespace
+
+QueryServer::QueryServer(const RequestHandler& request_handler) : request_handler_(request_handler) {}
+
+void QueryServer::Serve(istream& input, ostream& output) const {
+
+	for (string line; getline(input, line);) {
+
+		if (line.find_first_not_of(" \t\r"s) == string::npos) {
+			continue;
+		}
+		output << ProcessLine(line) << endl;
+	}
+}
+
+string QueryServer::ProcessLine(const string& line) const {
+
+	ostringstream response;
+	response << setprecision(6);
+	optional<int> request_id; // echoed in an error response, so a pipelining client can match it
+
+	try {
+		istringstream request_stream{ line };
+		json::Node node = json::LoadNode(request_stream);
+
+		if (node.IsDict()) {
+			if (auto it = node.AsDict().find("id"s); it != node.AsDict().end() && it->second.IsInt()) {
+				request_id = it->second.AsInt();
+			}
+		}
+		json::Node{ request_handler_.ProcessRequest(ReadStatRequest(node)) }.Print(response);
+	}
+	catch (const exception& e) {
+		response.str(""s);
+		json::Builder error_builder;
+		error_builder.StartDict();
+		if (request_id) {
+			error_builder.Key("request_id"s).Value(*request_id);
+		}
+		error_builder.Key("error_message"s).Value(string{ e.what() });
+		error_builder.EndDict().Build().Print(response);
+	}
+	return response.str();
+}
+
+#ifdef TRANSPORT_UNIX_SOCKETS
+
+bool QueryServer::ServeUnixSocket(const filesystem::path& socket_path) const {
+
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	const string path = socket_path.string();
+
+	if (path.size() >= sizeof(address.sun_path)) {
+		return false;
+	}
+	path.copy(address.sun_path, path.size());
+
+	const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener < 0) {
+		return false;
+	}
+	unlink(path.c_str());
+
+	if (bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0 || listen(listener, SOMAXCONN) < 0) {
+		close(listener);
+		return false;
+	}
+
+	// A client closing its connection early must not stop the server with SIGPIPE;
+	// the failed write ends only that connection
+	signal(SIGPIPE, SIG_IGN);
+
+	// Connections being served; a new one is accepted only below MAX_CONNECTIONS
+	mutex connections_mutex;
+	condition_variable connection_closed;
+	size_t connection_count = 0;
+
+	auto release_connection = [&connections_mutex, &connection_closed, &connection_count]() {
+		lock_guard lock(connections_mutex);
+		--connection_count;
+		connection_closed.notify_all();
+	};
+
+	for (;;) {
+		{
+			unique_lock lock(connections_mutex);
+			connection_closed.wait(lock, [&connection_count] { return connection_count < MAX_CONNECTIONS; });
+			++connection_count;
+		}
+
+		const int connection = accept(listener, nullptr, nullptr);
+		if (connection >= 0) {
+			try {
+				thread([this, connection, &release_connection] {
+					ServeConnection(connection);
+					release_connection();
+				}).detach();
+				continue;
+			}
+			catch (const system_error&) {
+				close(connection);
+				this_thread::sleep_for(chrono::milliseconds(100));
+			}
+		}
+		// Out of descriptors or memory: wait for connections being served to close
+		else if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+			this_thread::sleep_for(chrono::milliseconds(100));
+		}
+		else if (errno != EINTR && errno != ECONNABORTED) {
+			release_connection();
+			close(listener);
+
+			// The connection threads refer to the counter above
+			unique_lock lock(connections_mutex);
+			connection_closed.wait(lock, [&connection_count] { return connection_count == 0; });
+			return false;
+		}
+		release_connection();
+	}
+}
+
+void QueryServer::ServeConnection(int connection) const {
+
+	string buffer;
+	char chunk[4096];
+
+	for (ssize_t received; (received = read(connection, chunk, sizeof(chunk))) != 0;) {
+
+		if (received < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+
+		buffer.append(chunk, static_cast<size_t>(received));
+
+		size_t line_begin = 0;
+		for (size_t line_end; (line_end = buffer.find('\n', line_begin)) != string::npos; line_begin = line_end + 1) {
+
+			const string line = buffer.substr(line_begin, line_end - line_begin);
+			if (line.find_first_not_of(" \t\r"s) == string::npos) {
+				continue;
+			}
+
+			const string response = ProcessLine(line) + '\n';
+			for (size_t sent = 0; sent < response.size();) {
+				const ssize_t written = write(connection, response.data() + sent, response.size() - sent);
+				if (written < 0 && errno == EINTR) {
+					continue;
+				}
+				if (written <= 0) {
+					close(connection);
+					return;
+				}
+				sent += static_cast<size_t>(written);
+			}
+		}
+		buffer.erase(0, line_begin);
+
+		if (buffer.size() > MAX_LINE_SIZE) {
+			break;
+		}
+	}
+	close(connection);
+}
+
+#else
+
+bool QueryServer::ServeUnixSocket(const filesystem::path&) const {
+	return false;
+}
+
+void QueryServer::ServeConnection(int) const {
+}
+
+#endif
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "request_handler.h"
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+// Keeps a loaded base in memory and answers stat requests one at a time:
+// each input line holds one JSON request, each output line one JSON response
+class QueryServer {
+public:
+	explicit QueryServer(const RequestHandler& request_handler);
+
+	// Serves until the input ends
+	void Serve(std::istream& input, std::ostream& output) const;
+
+	// Serves every accepted connection on its own thread until the process is stopped,
+	// at most 64 connections at once; a connection sending a request line over 1 MiB is closed.
+	// Returns false if the socket cannot be set up, accepting fails other than for lack
+	// of descriptors or memory, or Unix sockets are not supported.
+	bool ServeUnixSocket(const std::filesystem::path& socket_path) const;
+
+private:
+	std::string ProcessLine(const std::string& line) const;
+	void ServeConnection(int connection) const;
+
+	const RequestHandler& request_handler_;
+};
@@ -1,30 +1,34 @@
-#pragma once
-
-#include "transport_catalogue.h"
-#include "json_reader.h"
-#include "json_builder.h"
-#include "transport_router.h"
-#include "router.h"
-
-#include <iostream>
-#include <optional>
-
-class RequestHandler {
-public:
-	RequestHandler(const transport::TransportCatalogue& transport_catalogue, const Requests& requests, 
-					const InputAttrs& attrs, const std::optional<routing::TransportRouter>& router);
-
-	void ProcessRequests(std::ostream& os);
-
-private:
-
-	void ProcessBusRequest(const Request& request, json::Builder& response_builder);
-	void ProcessStopRequest(const Request& request, json::Builder& response_builder);
-	void ProcessRouteRequest(const Request& request, json::Builder& response_builder);
-	void ProcessMapRequest(json::Builder& response_builder);
-
-	const transport::TransportCatalogue& transport_catalogue_; 
-	const Requests& requests_;
-	const InputAttrs& attrs_;
-	const std::optional<routing::TransportRouter>& router_;
-};
+#pragma once
+
+#include "transport_catalogue.h"
+#include "json_reader.h"
+#include "json_builder.h"
+#include "transport_router.h"
+#include "router.h"
+
+#include <iostream>
+#include <optional>
+
+class RequestHandler {
+public:
+	RequestHandler(const transport::TransportCatalogue& transport_catalogue, 
+					const InputAttrs& attrs, const std::optional<routing::TransportRouter>& router);
+
+	void ProcessRequests(const Requests& requests, std::ostream& os) const;
+
+	// Safe to call from several threads at once
+	json::Dict ProcessRequest(const Request& request) const;
+
+private:
+
+	void ProcessBusRequest(const Request& request, json::Builder& response_builder) const;
+	void ProcessStopRequest(const Request& request, json::Builder& response_builder) const;
+	void ProcessRouteRequest(const Request& request, json::Builder& response_builder) const;
+	void ProcessRouteMatrixRequest(const Request& request, json::Builder& response_builder) const;
+	json::Array BuildRouteItems(const std::vector<graph::EdgeId>& edges) const;
+	void ProcessMapRequest(json::Builder& response_builder) const;
+
+	const transport::TransportCatalogue& transport_catalogue_; 
+	const InputAttrs& attrs_;
+	const std::optional<routing::TransportRouter>& router_;
+};
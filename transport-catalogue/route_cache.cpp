@@ -0,0 +1,55 @@
+#include "route_cache.h"
+
+#include <utility>
+
+using namespace std;
+
+namespace routing {
+
+RouteTreeCache::RouteTreeCache(size_t memory_limit) : memory_limit_(memory_limit) {}
+
+shared_ptr<const RouteTreeCache::Tree> RouteTreeCache::Find(graph::VertexId root) {
+	lock_guard lock(mutex_);
+
+	auto it = tree_positions_.find(root);
+	if (it == tree_positions_.end()) {
+		++stats_.misses;
+		return nullptr;
+	}
+	++stats_.hits;
+	trees_.splice(trees_.begin(), trees_, it->second);
+	return trees_.front();
+}
+
+void RouteTreeCache::Insert(shared_ptr<const Tree> tree) {
+	const size_t tree_size = GetTreeSize(*tree);
+	if (tree_size > memory_limit_) {
+		return;
+	}
+	lock_guard lock(mutex_);
+
+	// Another thread may have searched from the same source meanwhile
+	if (tree_positions_.count(tree->root)) {
+		return;
+	}
+	while (stats_.memory_size + tree_size > memory_limit_) {
+		stats_.memory_size -= GetTreeSize(*trees_.back());
+		tree_positions_.erase(trees_.back()->root);
+		trees_.pop_back();
+	}
+	trees_.push_front(move(tree));
+	tree_positions_[trees_.front()->root] = trees_.begin();
+	stats_.memory_size += tree_size;
+	stats_.tree_count = trees_.size();
+}
+
+RouteCacheStats RouteTreeCache::GetStats() const {
+	lock_guard lock(mutex_);
+	return stats_;
+}
+
+size_t RouteTreeCache::GetTreeSize(const Tree& tree) {
+	return sizeof(Tree) + tree.weights.size() * sizeof(double) + tree.prev_edges.size() * sizeof(graph::EdgeId);
+}
+
+} // namespace routing
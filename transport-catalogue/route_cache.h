@@ -0,0 +1,50 @@
+#pragma once
+
+#include "graph.h"
+#include "dijkstra_router.h"
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace routing {
+
+struct RouteCacheStats {
+	size_t hits = 0;
+	size_t misses = 0;
+	size_t tree_count = 0;
+	size_t memory_size = 0; // bytes
+};
+
+// Shortest path trees of the most recently used route sources within a memory limit.
+// A route from a cached source is walked back from the target without a search.
+// Safe to use from several threads at once; a found tree stays valid after eviction.
+class RouteTreeCache {
+public:
+	using Tree = graph::DijkstraRouter<double>::ShortestPathTree;
+
+	explicit RouteTreeCache(size_t memory_limit); // bytes
+
+	// nullptr on a miss
+	std::shared_ptr<const Tree> Find(graph::VertexId root);
+
+	// Evicts the least recently used trees to make room; a tree over the limit is not kept
+	void Insert(std::shared_ptr<const Tree> tree);
+
+	RouteCacheStats GetStats() const;
+
+private:
+	using TreeList = std::list<std::shared_ptr<const Tree>>;
+
+	static size_t GetTreeSize(const Tree& tree);
+
+	const size_t memory_limit_;
+	mutable std::mutex mutex_;
+	TreeList trees_; // most recently used first
+	std::unordered_map<graph::VertexId, TreeList::iterator> tree_positions_;
+	RouteCacheStats stats_;
+};
+
+} // namespace routing
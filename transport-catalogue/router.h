@@ -3,29 +3,193 @@
 #include "graph.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <condition_variable>
 #include <cstdint>
+#include <functional>
 #include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 namespace graph {
 
+	namespace detail {
+
+		// Blocks each of thread_count participants until all of them have arrived.
+		// Reusable: the generation counter separates consecutive phases.
+		class Barrier {
+		public:
+			explicit Barrier(size_t thread_count)
+				: thread_count_(thread_count) {
+			}
+
+			void ArriveAndWait() {
+				std::unique_lock lock(mutex_);
+				const size_t generation = generation_;
+				if (++arrived_ == thread_count_) {
+					arrived_ = 0;
+					++generation_;
+					condition_.notify_all();
+				}
+				else {
+					condition_.wait(lock, [this, generation] { return generation != generation_; });
+				}
+			}
+
+		private:
+			std::mutex mutex_;
+			std::condition_variable condition_;
+			const size_t thread_count_;
+			size_t arrived_ = 0;
+			size_t generation_ = 0;
+		};
+
+	}  // namespace detail
+
+	// All-pairs route table stored row-major in two flat arrays (structure of arrays):
+	// weights and 32-bit ids of the last edge of each route. Special values of the
+	// edge id mark an unreachable cell and a route without edges (from a vertex to itself).
+	// The arrays are either owned by the table or read in place from external memory
+	// (e.g. a mapped file), which the table then keeps alive through a shared holder.
+	// An external table may come with a check which a row has to pass before its first use.
+	template <typename Weight>
+	class RoutesTable {
+	public:
+		using PrevEdge = uint32_t;
+		// Gets a row with its vertex_count cells; true if they can be used
+		using RowCheck = std::function<bool(VertexId from, const Weight* weights, const PrevEdge* prev_edges)>;
+
+		static constexpr PrevEdge NO_EDGE = std::numeric_limits<PrevEdge>::max();
+		static constexpr PrevEdge UNREACHABLE = NO_EDGE - 1;
+		static constexpr PrevEdge MAX_EDGE_ID = UNREACHABLE - 1; // the largest id that is not a special value
+
+		RoutesTable() = default;
+
+		explicit RoutesTable(size_t vertex_count)
+			: vertex_count_(vertex_count)
+			, owned_weights_(vertex_count * vertex_count)
+			, owned_prev_edges_(vertex_count * vertex_count, UNREACHABLE)
+			, weights_(owned_weights_.data())
+			, prev_edges_(owned_prev_edges_.data()) {
+		}
+
+		RoutesTable(size_t vertex_count, std::vector<Weight>&& weights, std::vector<PrevEdge>&& prev_edges)
+			: vertex_count_(vertex_count)
+			, owned_weights_(std::move(weights))
+			, owned_prev_edges_(std::move(prev_edges))
+			, weights_(owned_weights_.data())
+			, prev_edges_(owned_prev_edges_.data()) {
+			if (owned_weights_.size() != vertex_count * vertex_count || owned_prev_edges_.size() != owned_weights_.size()) {
+				throw std::invalid_argument("Routes table size does not match vertex count");
+			}
+		}
+
+		// Read-only table over vertex_count * vertex_count cells stored elsewhere; nothing is copied.
+		// Without row_check the rows are trusted.
+		RoutesTable(size_t vertex_count, const Weight* weights, const PrevEdge* prev_edges,
+			std::shared_ptr<const void> storage, RowCheck row_check = {})
+			: vertex_count_(vertex_count)
+			, weights_(weights)
+			, prev_edges_(prev_edges)
+			, storage_(std::move(storage))
+			, row_check_(std::move(row_check)) {
+			if (row_check_) {
+				row_states_.reset(new std::atomic<uint8_t>[vertex_count]());
+			}
+		}
+
+		RoutesTable(const RoutesTable&) = delete;
+		RoutesTable& operator=(const RoutesTable&) = delete;
+		RoutesTable(RoutesTable&&) = default;
+		RoutesTable& operator=(RoutesTable&&) = default;
+
+		size_t GetVertexCount() const {
+			return vertex_count_;
+		}
+
+		// Runs the row check on the first call for the row and remembers its result
+		bool IsRowValid(VertexId from) const {
+			if (!row_check_) {
+				return true;
+			}
+			std::atomic<uint8_t>& row_state = row_states_[from];
+			if (row_state.load(std::memory_order_acquire) == ROW_UNCHECKED) {
+				// Threads meeting an unchecked row may check it at the same time, with the same result
+				const bool is_valid = row_check_(from, weights_ + Index(from, 0), prev_edges_ + Index(from, 0));
+				row_state.store(is_valid ? ROW_VALID : ROW_INVALID, std::memory_order_release);
+			}
+			return row_state.load(std::memory_order_acquire) == ROW_VALID;
+		}
+
+		bool IsReachable(VertexId from, VertexId to) const {
+			return prev_edges_[Index(from, to)] != UNREACHABLE;
+		}
+
+		Weight GetWeight(VertexId from, VertexId to) const {
+			return weights_[Index(from, to)];
+		}
+
+		std::optional<EdgeId> GetPrevEdge(VertexId from, VertexId to) const {
+			const PrevEdge prev_edge = prev_edges_[Index(from, to)];
+			if (prev_edge == NO_EDGE || prev_edge == UNREACHABLE) {
+				return std::nullopt;
+			}
+			return prev_edge;
+		}
+
+		// Owned tables only
+		void Set(VertexId from, VertexId to, Weight weight, std::optional<EdgeId> prev_edge) {
+			owned_weights_[Index(from, to)] = weight;
+			owned_prev_edges_[Index(from, to)] = prev_edge ? static_cast<PrevEdge>(*prev_edge) : NO_EDGE;
+		}
+
+		// Row-major arrays of GetVertexCount() * GetVertexCount() cells
+		const Weight* GetWeights() const {
+			return weights_;
+		}
+
+		const PrevEdge* GetPrevEdges() const {
+			return prev_edges_;
+		}
+
+	private:
+		template <typename>
+		friend class Router;
+
+		size_t Index(VertexId from, VertexId to) const {
+			return from * vertex_count_ + to;
+		}
+
+		static constexpr uint8_t ROW_UNCHECKED = 0;
+		static constexpr uint8_t ROW_VALID = 1;
+		static constexpr uint8_t ROW_INVALID = 2;
+
+		size_t vertex_count_ = 0;
+		std::vector<Weight> owned_weights_;
+		std::vector<PrevEdge> owned_prev_edges_;
+		const Weight* weights_ = nullptr;
+		const PrevEdge* prev_edges_ = nullptr;
+		std::shared_ptr<const void> storage_; // keeps external arrays alive
+		RowCheck row_check_;
+		std::unique_ptr<std::atomic<uint8_t>[]> row_states_; // per row, with row_check_ only
+	};
+
 	template <typename Weight>
 	class Router {
 	private:
 		using Graph = DirectedWeightedGraph<Weight>;
-		
-		struct RouteInternalData {
-			Weight weight;
-			std::optional<EdgeId> prev_edge;
-		};
+		using PrevEdge = typename RoutesTable<Weight>::PrevEdge;
 
 	public:
-		using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+		using RoutesInternalData = RoutesTable<Weight>;
 
 		explicit Router(const Graph& graph);
 
@@ -36,6 +200,8 @@ namespace graph {
 			std::vector<EdgeId> edges;
 		};
 
+		// Throws std::invalid_argument if the row of from is corrupted: it fails the check of the table,
+		// or its path refers to an unknown edge or does not end within vertex count edges
 		std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
 		const RoutesInternalData& GetRoutesInternalData() const;
@@ -43,45 +209,101 @@ namespace graph {
 	private:
 
 		void InitializeRoutesInternalData(const Graph& graph) {
+			// Edge ids run up to GetEdgeCount() - 1, which must not reach the special values
+			if (graph.GetEdgeCount() != 0 && graph.GetEdgeCount() - 1 > RoutesInternalData::MAX_EDGE_ID) {
+				throw std::length_error("Too many edges for the routes table");
+			}
 			const size_t vertex_count = graph.GetVertexCount();
 			for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-				routes_internal_data_[vertex][vertex] = RouteInternalData{ ZERO_WEIGHT, std::nullopt };
+				routes_internal_data_.Set(vertex, vertex, ZERO_WEIGHT, std::nullopt);
 				for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
 					const auto& edge = graph.GetEdge(edge_id);
 					if (edge.weight < ZERO_WEIGHT) {
 						throw std::domain_error("Edges' weights should be non-negative");
 					}
-					auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-					if (!route_internal_data || route_internal_data->weight > edge.weight) {
-						route_internal_data = RouteInternalData{ edge.weight, edge_id };
+					if (!routes_internal_data_.IsReachable(vertex, edge.to)
+						|| routes_internal_data_.GetWeight(vertex, edge.to) > edge.weight) {
+						routes_internal_data_.Set(vertex, edge.to, edge.weight, edge_id);
 					}
 				}
 			}
 		}
 
-		void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-			const RouteInternalData& route_to) {
-			auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-			const Weight candidate_weight = route_from.weight + route_to.weight;
-			if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-				route_relaxing = { candidate_weight,
-								  route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge };
+		// Rows are walked as plain arrays: the pivot row is read sequentially and the
+		// relaxed row is written sequentially, both from the same two flat buffers.
+		void RelaxRoutesInternalDataThroughVertex(VertexId rows_begin, VertexId rows_end, size_t vertex_count,
+			VertexId vertex_through) {
+			constexpr PrevEdge UNREACHABLE = RoutesInternalData::UNREACHABLE;
+			constexpr PrevEdge NO_EDGE = RoutesInternalData::NO_EDGE;
+
+			Weight* const weights = routes_internal_data_.owned_weights_.data();
+			PrevEdge* const prev_edges = routes_internal_data_.owned_prev_edges_.data();
+			const Weight* const weights_through = weights + vertex_through * vertex_count;
+			const PrevEdge* const prev_edges_through = prev_edges + vertex_through * vertex_count;
+
+			for (VertexId vertex_from = rows_begin; vertex_from < rows_end; ++vertex_from) {
+				Weight* const weights_from = weights + vertex_from * vertex_count;
+				PrevEdge* const prev_edges_from = prev_edges + vertex_from * vertex_count;
+
+				const PrevEdge prev_edge_from = prev_edges_from[vertex_through];
+				if (prev_edge_from == UNREACHABLE) {
+					continue;
+				}
+				const Weight weight_from = weights_from[vertex_through];
+
+				for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
+					const PrevEdge prev_edge_to = prev_edges_through[vertex_to];
+					if (prev_edge_to == UNREACHABLE) {
+						continue;
+					}
+					const Weight candidate_weight = weight_from + weights_through[vertex_to];
+					if (prev_edges_from[vertex_to] == UNREACHABLE || candidate_weight < weights_from[vertex_to]) {
+						weights_from[vertex_to] = candidate_weight;
+						prev_edges_from[vertex_to] = prev_edge_to != NO_EDGE ? prev_edge_to : prev_edge_from;
+					}
+				}
 			}
 		}
 
-		void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-			for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-				if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-					for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-						if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-							RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-						}
-					}
+		// Floyd-Warshall with the rows split between threads. While relaxing through
+		// vertex_through, neither its row nor its column can change (the diagonal is
+		// zero), so rows are independent within one pivot step and the threads only
+		// synchronize between steps. The relaxation order of every cell is the same
+		// as in the sequential loop, so the result is bit-identical to it.
+		void RelaxRoutesInternalData(size_t vertex_count) {
+			const size_t thread_count = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(),
+				vertex_count / MIN_ROWS_PER_THREAD));
+
+			if (thread_count == 1) {
+				for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
+					RelaxRoutesInternalDataThroughVertex(0, vertex_count, vertex_count, vertex_through);
+				}
+				return;
+			}
+
+			detail::Barrier barrier(thread_count);
+			auto relax_rows = [this, vertex_count, &barrier](VertexId rows_begin, VertexId rows_end) {
+				for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
+					RelaxRoutesInternalDataThroughVertex(rows_begin, rows_end, vertex_count, vertex_through);
+					barrier.ArriveAndWait();
 				}
+			};
+
+			std::vector<std::thread> workers;
+			workers.reserve(thread_count - 1);
+			for (size_t thread_index = 1; thread_index < thread_count; ++thread_index) {
+				workers.emplace_back(relax_rows, vertex_count * thread_index / thread_count,
+					vertex_count * (thread_index + 1) / thread_count);
+			}
+			relax_rows(0, vertex_count / thread_count);
+
+			for (std::thread& worker : workers) {
+				worker.join();
 			}
 		}
 
 		static constexpr Weight ZERO_WEIGHT{};
+		static constexpr size_t MIN_ROWS_PER_THREAD = 64;
 		const Graph& graph_;
 		RoutesInternalData routes_internal_data_;
 	};
@@ -89,15 +311,10 @@ namespace graph {
 	template <typename Weight>
 	Router<Weight>::Router(const Graph& graph)
 		: graph_(graph)
-		, routes_internal_data_(graph.GetVertexCount(),
-			std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+		, routes_internal_data_(graph.GetVertexCount())
 	{
 		InitializeRoutesInternalData(graph);
-
-		const size_t vertex_count = graph.GetVertexCount();
-		for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-			RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
-		}
+		RelaxRoutesInternalData(graph.GetVertexCount());
 	}
 
 	template <typename Weight>
@@ -109,16 +326,26 @@ namespace graph {
 	template <typename Weight>
 	std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
 		VertexId to) const {
-		const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-		if (!route_internal_data) {
+		const size_t vertex_count = routes_internal_data_.GetVertexCount();
+		if (from >= vertex_count || to >= vertex_count) {
+			throw std::out_of_range("Vertex id is out of range");
+		}
+		if (!routes_internal_data_.IsRowValid(from)) {
+			throw std::invalid_argument("Routes table is corrupted");
+		}
+		if (!routes_internal_data_.IsReachable(from, to)) {
 			return std::nullopt;
 		}
-		const Weight weight = route_internal_data->weight;
+		const Weight weight = routes_internal_data_.GetWeight(from, to);
 		std::vector<EdgeId> edges;
-		for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
+		for (std::optional<EdgeId> edge_id = routes_internal_data_.GetPrevEdge(from, to);
 			edge_id;
-			edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+			edge_id = routes_internal_data_.GetPrevEdge(from, graph_.GetEdge(*edge_id).from))
 		{
+			// A shortest path has fewer edges than vertices; a longer walk runs around a cycle
+			if (*edge_id >= graph_.GetEdgeCount() || edges.size() == vertex_count) {
+				throw std::invalid_argument("Routes table is corrupted");
+			}
 			edges.push_back(*edge_id);
 		}
 		std::reverse(edges.begin(), edges.end());
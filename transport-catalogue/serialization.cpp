@@ -1,225 +1,1267 @@
-#include "serialization.h"
-#include "transport_catalogue.h"
-#include "transport_router.h"
-#include "router.h"
-
-#include <transport_catalogue.pb.h>
-#include <string>
-#include <fstream>
-
-using namespace std;
-using namespace routing;
-
-void ReadTransportRoutesData(const graph::Router<double>& router, serialize::TransportCatalogue& serialize_transport);
-void ReadTransportBase(const serialize::TransportCatalogue& serialize_transport, transport::TransportCatalogue& transport);
-void ReadRoutingSettings(const serialize::RoutingSettings& routing_settings, routing::Attrs& routing_attrs);
-
-bool SerializeTransportCatalogue(	serialize::TransportCatalogue& serialize_transport, 
-									const filesystem::path& serialize_result_path) {
-
-	transport::TransportCatalogue transport;
-	routing::Attrs routing_attrs = { 0,0 };
-	ReadTransportBase(serialize_transport, transport);
-	ReadRoutingSettings(serialize_transport.routing_settings(), routing_attrs);
-
-	TransportRouter transport_router{ transport, routing_attrs };
-	
-	ReadTransportRoutesData(transport_router.GetRouter(), serialize_transport);
-
-	ofstream ofs{ serialize_result_path, ios::binary };
-
-	if (!serialize_transport.SerializeToOstream(&ofs)) {
-		return false;
-	}
-	else {
-		return true;
-	}
-}
-
-void ReadRenderSettings(serialize::RenderSettings& render_settings, renderer::Attrs& render_attrs);
-void ReadTransportRoutesData(const serialize::RoutesInternalData& serialize_routes_data, TransportRoutesData& routes_data);
-
-bool DeserializeTransportCatalogue(filesystem::path& serialize_result_path, transport::TransportCatalogue& transport,
-									InputAttrs& attrs, optional<routing::TransportRouter>& router,
-									bool is_route_request_presence) {
-	
-	serialize::TransportCatalogue serialize_transport;
-
-	ifstream ifs{ serialize_result_path, ios::binary };
-
-	if (!serialize_transport.ParseFromIstream(&ifs)) {
-		return false;
-	}
-	ReadTransportBase(serialize_transport, transport);
-	ReadRenderSettings(*serialize_transport.mutable_render_settings(), attrs.render_attrs);
-
-	if (is_route_request_presence) {
-
-		ReadRoutingSettings(serialize_transport.routing_settings(), attrs.routing_attrs);
-		
-		TransportRoutesData routes_data;
-		ReadTransportRoutesData(serialize_transport.routes_data(), routes_data);
-
-		router.emplace(transport, attrs.routing_attrs, move(routes_data));
-	}
-	return true;
-}
-
-void ReadTransportRoutesData(const graph::Router<double>& router, serialize::TransportCatalogue& serialize_transport) {
-
-	auto serialize_routes_data = serialize_transport.mutable_routes_data();
-
-	for (auto& routes_data : router.GetRoutesInternalData()) {
-
-		auto vector_routes_data = serialize_routes_data->add_routes_data();
-
-		for (auto& route_data : routes_data) {
-
-			auto serialize_route_data = vector_routes_data->add_route_data();
-
-			if (route_data.has_value()) {
-
-				serialize_route_data->mutable_weight()->set_value(route_data->weight);
-
-				if (route_data->prev_edge.has_value()) {
-					serialize_route_data->mutable_prev_edge()->set_value(route_data->prev_edge.value());
-				}
-				
-			}
-		}
-	}
-}
-
-void ReadStopData(const serialize::StopData& stop_data, transport::TransportCatalogue& transport);
-void ReadBusData(const serialize::BusData& bus_data, transport::TransportCatalogue& transport);
-
-void ReadTransportBase(const serialize::TransportCatalogue &serialize_transport, transport::TransportCatalogue& transport) {
-
-	auto& stops = serialize_transport.stops_data();
-	auto& buses = serialize_transport.buses_data();
-
-	for (auto& stop_data : stops) {
-		ReadStopData(stop_data, transport);
-	}
-	for (auto& bus_data : buses) {
-		ReadBusData(bus_data, transport);
-	}
-}
-
-svg::Color GetColor(serialize::Color& color);
-svg::Point GetPoint(const serialize::Point& point);
-
-void ReadRenderSettings(serialize::RenderSettings& render_settings, renderer::Attrs& render_attrs) {
-
-	render_attrs.map_width = render_settings.map_width();
-	render_attrs.map_height = render_settings.map_height();
-	render_attrs.map_padding = render_settings.map_padding();
-	render_attrs.stop_radius = render_settings.stop_radius();
-	render_attrs.line_width = render_settings.line_width();
-	render_attrs.bus_label_font_size = render_settings.bus_label_font_size();
-	render_attrs.stop_label_font_size = render_settings.stop_label_font_size();
-	render_attrs.underlayer_width = render_settings.underlayer_width();
-
-	render_attrs.bus_label_offset = GetPoint(render_settings.bus_label_offset());
-	render_attrs.stop_label_offset = GetPoint(render_settings.stop_label_offset());
-	render_attrs.underlayer_color = GetColor(*render_settings.mutable_underlayer_color());
-
-	for (auto& color : *render_settings.mutable_stroke_colors()) {
-		render_attrs.stroke_colors.push_back(GetColor(color));
-	}
-}
-
-void ReadStopData(const serialize::StopData& stop_data, transport::TransportCatalogue& transport) {
-
-	string stop_name = stop_data.name();
-	double lat = stop_data.latitude();
-	double lng = stop_data.longitude();
-
-	if (!stop_data.road_distances_size()) {
-		transport.AddStop(move(stop_name), transport::StopData{ geo::Coordinates{ lat, lng } });
-	}
-	else {
-		unordered_map<string_view, size_t> distance_to_stop;
-
-		auto& road_distances = stop_data.road_distances();
-
-		for (auto& road_distance : road_distances) {
-
-			auto& transport_stop_names = transport.GetStopNames();
-			if (auto word_it = transport_stop_names.find(road_distance.stop_name()); word_it != transport_stop_names.end()) {
-				distance_to_stop[*word_it] = road_distance.distance();
-			}
-			else {
-				distance_to_stop[*transport_stop_names.insert(road_distance.stop_name()).first] = road_distance.distance();
-			}
-		}
-		transport.AddStop(move(stop_name), transport::StopData{ geo::Coordinates{ lat, lng }, move(distance_to_stop) });
-	}
-}
-
-void ReadBusData(const serialize::BusData& bus_data, transport::TransportCatalogue& transport) {
-
-	bool  path_is_ring = bus_data.is_roundtrip();
-	string bus_name = bus_data.name();
-
-	list<string> bus_path;
-
-	auto& stops = bus_data.stops();
-
-	for (auto& stop : stops) {
-		bus_path.push_back(stop);
-	}
-	transport.AddBus(move(bus_name), move(bus_path), path_is_ring);
-}
-
-void ReadRoutingSettings(const serialize::RoutingSettings& routing_settings, routing::Attrs& routing_attrs) {
-
-	routing_attrs.bus_velocity = routing_settings.bus_velocity();
-	routing_attrs.bus_wait_time = routing_settings.bus_wait_time();
-}
-
-svg::Color GetColor(serialize::Color& color) {
-	if (!color.color_str().empty()) {
-		return move(*color.mutable_color_str());
-	}
-	else {
-		uint8_t red = static_cast<uint8_t>(color.red());
-		uint8_t green = static_cast<uint8_t>(color.green());
-		uint8_t blue = static_cast<uint8_t>(color.blue());
-
-		if (!color.has_opacity()) {
-			return svg::Rgb(red, green, blue);
-		}
-		else {
-			double opacity = color.opacity().value();
-			return svg::Rgba(red, green, blue, opacity);
-		}
-	}
-}
-
-svg::Point GetPoint(const serialize::Point& point) {
-	return svg::Point{ point.x(), point.y() };
-}
-
-void ReadTransportRoutesData(const serialize::RoutesInternalData& serialize_routes_data, TransportRoutesData& routes_data) {
-
-	for (auto& serialize_vector_route_data : serialize_routes_data.routes_data()) {
-
-		auto& vector_route_data = routes_data.emplace_back();
-
-		for (auto& serialize_route_data : serialize_vector_route_data.route_data()) {
-
-			auto& route_data = vector_route_data.emplace_back();
-
-			if (serialize_route_data.has_weight()) {
-
-				route_data.emplace();
-				route_data->weight = serialize_route_data.weight().value();
-			
-				if (serialize_route_data.has_prev_edge()) {
-					route_data->prev_edge.emplace(serialize_route_data.prev_edge().value());
-				}
-			}
-		}
-	}
+#include "serialization.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+#include "router.h"
+#include "mapped_base.h"
+#include "checksum.h"
+#include "parallel.h"
+
+#include <transport_catalogue.pb.h>
+#include <transport_router.pb.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/util/delimited_message_util.h>
+#include <zlib.h>
+#include <algorithm>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <unordered_set>
+#include <variant>
+
+using namespace std;
+using namespace routing;
+
+using google::protobuf::io::ZeroCopyInputStream;
+using google::protobuf::io::ZeroCopyOutputStream;
+
+namespace {
+
+constexpr char BASE_MAGIC[8] = { 'T', 'C', 'P', 'R', 'O', 'T', 'O', 'B' };
+constexpr uint32_t BASE_VERSION = 2;
+constexpr size_t BASE_FILE_HEADER_SIZE = 64;
+
+struct BaseSection {
+	uint64_t size = 0; // bytes
+	uint64_t checksum = 0;
+};
+
+// Fixed-size little-endian header in front of the protobuf stream. It is written last, once
+// the sections are known, so a foreign or truncated file is rejected by its first bytes and
+// its size, and a damaged section by its checksum, before the section is parsed.
+struct BaseFileHeader {
+	uint32_t version = BASE_VERSION;
+	BaseSection catalogue; // BaseHeader up to BaseSettings, checked in CHECKSUM_CHUNK_SIZE pieces
+	BaseSection graph; // EdgesBlock messages, checked by block
+	BaseSection routes; // RoutesBlock messages, checked by block; empty without precomputed routes
+};
+
+} // namespace
+
+bool WriteTransportRoutesData(const TransportRoutesData& routes_data, size_t block_rows, serialize::BlockCodec codec,
+							  ZeroCopyOutputStream& output, BaseSection& section);
+bool WriteTransportGraph(const TransportRouter& transport_router, size_t block_size, serialize::BlockCodec codec,
+						 ZeroCopyOutputStream& output, BaseSection& section);
+bool WriteTransportHierarchy(const TransportHierarchy& hierarchy, size_t vertex_count, size_t block_size,
+							 serialize::BlockCodec codec, ZeroCopyOutputStream& output, BaseSection& section);
+void ReadTransportBase(const serialize::TransportCatalogue& serialize_transport, transport::TransportCatalogue& transport);
+void ReadRoutingSettings(const serialize::RoutingSettings& routing_settings, routing::Attrs& routing_attrs);
+void WriteBusStats(const transport::TransportCatalogue& transport, serialize::TransportCatalogue& serialize_transport);
+void WriteStopIds(const transport::TransportCatalogue& transport, serialize::TransportCatalogue& serialize_transport);
+bool WriteBase(const transport::TransportCatalogue& transport, const serialize::TransportCatalogue& serialize_transport,
+			   const TransportRouter& transport_router, const TransportRoutesData* routes_data,
+			   const TransportHierarchy* hierarchy, serialize::BlockCodec codec, ZeroCopyOutputStream& output,
+			   BaseFileHeader& file_header);
+void WriteFileHeader(const BaseFileHeader& file_header, ostream& os);
+bool ReadFileHeader(istream& is, BaseFileHeader& file_header);
+bool WriteTransportCatalogue(const transport::TransportCatalogue& transport, serialize::TransportCatalogue& serialize_transport,
+							 const routing::Attrs& routing_attrs, const TransportRouter& transport_router,
+							 const SerializationSettings& serialization_settings);
+
+// Keep every edges and routes block far below the protobuf message size limit
+constexpr size_t EDGES_BLOCK_SIZE = 1 << 20;
+constexpr size_t ROUTES_BLOCK_CELLS = 1 << 20;
+
+bool SerializeTransportCatalogue(	serialize::TransportCatalogue& serialize_transport, 
+									const SerializationSettings& serialization_settings) {
+
+	transport::TransportCatalogue transport;
+	routing::Attrs routing_attrs = { 0,0 };
+	ReadTransportBase(serialize_transport, transport);
+	ReadRoutingSettings(serialize_transport.routing_settings(), routing_attrs);
+
+	const TransportRouter transport_router{ transport, routing_attrs };
+
+	return WriteTransportCatalogue(transport, serialize_transport, routing_attrs, transport_router, serialization_settings);
+}
+
+bool WriteTransportCatalogue(const transport::TransportCatalogue& transport, serialize::TransportCatalogue& serialize_transport,
+							 const routing::Attrs& routing_attrs, const TransportRouter& transport_router,
+							 const SerializationSettings& serialization_settings) {
+
+	const TransportRoutesData* routes_data = routing_attrs.router_mode == RouterMode::PRECOMPUTED
+		? &transport_router.GetRouter().GetRoutesInternalData() : nullptr;
+	const TransportHierarchy* hierarchy = routing_attrs.router_mode == RouterMode::CONTRACTED
+		? &transport_router.GetContractionRouter().GetHierarchyInternalData() : nullptr;
+
+	if (serialization_settings.format == BaseFormat::MAPPED) {
+		return WriteMappedBase(transport, routing_attrs, serialize_transport.render_settings(), transport_router,
+							   routes_data, hierarchy, serialization_settings.file);
+	}
+
+	WriteBusStats(transport, serialize_transport);
+	WriteStopIds(transport, serialize_transport);
+
+	ofstream ofs{ serialization_settings.file, ios::binary };
+	BaseFileHeader file_header;
+
+	WriteFileHeader(file_header, ofs); // space for the header, filled in below
+	{
+		google::protobuf::io::OstreamOutputStream output{ &ofs };
+
+		const serialize::BlockCodec codec = serialization_settings.compression == BaseCompression::ZLIB
+			? serialize::CODEC_ZLIB : serialize::CODEC_NONE;
+
+		if (!WriteBase(transport, serialize_transport, transport_router, routes_data, hierarchy, codec, output, file_header)) {
+			return false;
+		}
+	}
+	ofs.seekp(0);
+	WriteFileHeader(file_header, ofs);
+
+	return static_cast<bool>(ofs);
+}
+
+void WriteFileHeader(const BaseFileHeader& file_header, ostream& os) {
+
+	using google::protobuf::io::CodedOutputStream;
+
+	uint8_t data[BASE_FILE_HEADER_SIZE] = {};
+	uint8_t* position = copy(begin(BASE_MAGIC), end(BASE_MAGIC), data);
+	position = CodedOutputStream::WriteLittleEndian32ToArray(file_header.version, position);
+	position = CodedOutputStream::WriteLittleEndian32ToArray(0, position);
+
+	for (const BaseSection* section : { &file_header.catalogue, &file_header.graph, &file_header.routes }) {
+		position = CodedOutputStream::WriteLittleEndian64ToArray(section->size, position);
+		position = CodedOutputStream::WriteLittleEndian64ToArray(section->checksum, position);
+	}
+	os.write(reinterpret_cast<const char*>(data), sizeof(data));
+}
+
+bool ReadFileHeader(istream& is, BaseFileHeader& file_header) {
+
+	using google::protobuf::io::CodedInputStream;
+
+	uint8_t data[BASE_FILE_HEADER_SIZE] = {};
+
+	if (!is.read(reinterpret_cast<char*>(data), sizeof(data)) || !equal(begin(BASE_MAGIC), end(BASE_MAGIC), data)) {
+		return false;
+	}
+	const uint8_t* position = CodedInputStream::ReadLittleEndian32FromArray(data + sizeof(BASE_MAGIC), &file_header.version);
+	position += sizeof(uint32_t);
+
+	for (BaseSection* section : { &file_header.catalogue, &file_header.graph, &file_header.routes }) {
+		position = CodedInputStream::ReadLittleEndian64FromArray(position, &section->size);
+		position = CodedInputStream::ReadLittleEndian64FromArray(position, &section->checksum);
+	}
+	return file_header.version == BASE_VERSION;
+}
+
+bool WriteBase(const transport::TransportCatalogue& transport, const serialize::TransportCatalogue& serialize_transport,
+			   const TransportRouter& transport_router, const TransportRoutesData* routes_data,
+			   const TransportHierarchy* hierarchy, serialize::BlockCodec codec, ZeroCopyOutputStream& output,
+			   BaseFileHeader& file_header) {
+
+	using google::protobuf::util::SerializeDelimitedToZeroCopyStream;
+
+	serialize::BaseHeader header;
+	header.set_stop_count(serialize_transport.stops_data_size());
+	header.set_bus_count(serialize_transport.buses_data_size());
+
+	const size_t vertex_count = transport_router.GetGraph().GetVertexCount();
+	header.set_vertex_count(static_cast<uint32_t>(vertex_count));
+	header.set_edge_count(transport_router.GetGraph().GetEdgeCount());
+	header.set_edges_block_size(static_cast<uint32_t>(EDGES_BLOCK_SIZE));
+	header.set_block_codec(codec);
+
+	if (routes_data) {
+		header.set_routes_block_rows(static_cast<uint32_t>(max<size_t>(1, ROUTES_BLOCK_CELLS / max<size_t>(1, vertex_count))));
+	}
+	if (hierarchy) {
+		header.set_shortcut_count(hierarchy->shortcuts.size());
+	}
+
+	serialize::StopNames stop_names;
+
+	for (transport::StopId stop_id = 0; stop_id < transport.GetStopsCount(); ++stop_id) {
+		stop_names.add_names(string(transport.GetStopName(stop_id)));
+	}
+
+	serialize::BaseSettings settings;
+	*settings.mutable_render_settings() = serialize_transport.render_settings();
+	*settings.mutable_routing_settings() = serialize_transport.routing_settings();
+
+	// The catalogue section is built in memory for its checksum; it is small next to the routes
+	string catalogue;
+	{
+		google::protobuf::io::StringOutputStream catalogue_output{ &catalogue };
+
+		if (!SerializeDelimitedToZeroCopyStream(header, &catalogue_output)
+			|| !SerializeDelimitedToZeroCopyStream(stop_names, &catalogue_output)) {
+			return false;
+		}
+		for (auto& stop_data : serialize_transport.stops_data()) {
+			if (!SerializeDelimitedToZeroCopyStream(stop_data, &catalogue_output)) {
+				return false;
+			}
+		}
+		for (auto& bus_data : serialize_transport.buses_data()) {
+			if (!SerializeDelimitedToZeroCopyStream(bus_data, &catalogue_output)) {
+				return false;
+			}
+		}
+		if (!SerializeDelimitedToZeroCopyStream(settings, &catalogue_output)) {
+			return false;
+		}
+	}
+	file_header.catalogue = BaseSection{ catalogue.size(), ComputeSectionChecksums({ { catalogue.data(), catalogue.size() } }).front() };
+	{
+		google::protobuf::io::CodedOutputStream coded_output{ &output };
+		coded_output.WriteString(catalogue);
+
+		if (coded_output.HadError()) {
+			return false;
+		}
+	}
+
+	if (!WriteTransportGraph(transport_router, header.edges_block_size(), codec, output, file_header.graph)) {
+		return false;
+	}
+	if (routes_data) {
+		return WriteTransportRoutesData(*routes_data, header.routes_block_rows(), codec, output, file_header.routes);
+	}
+	if (hierarchy) {
+		return WriteTransportHierarchy(*hierarchy, vertex_count, EDGES_BLOCK_SIZE, codec, output, file_header.routes);
+	}
+	return true;
+}
+
+void WriteBaseRequests(const transport::TransportCatalogue& transport, serialize::TransportCatalogue& serialize_transport);
+void WriteRenderSettings(const renderer::Attrs& render_attrs, serialize::RenderSettings& render_settings);
+void WriteRoutingSettings(const routing::Attrs& routing_attrs, serialize::RoutingSettings& routing_settings);
+void ApplyBaseDelta(const BaseDelta& delta, serialize::TransportCatalogue& serialize_transport);
+vector<optional<graph::EdgeId>> MatchEdges(const transport::TransportCatalogue& previous_transport,
+										   const TransportRouter& previous_router,
+										   const transport::TransportCatalogue& transport, const TransportRouter& transport_router);
+bool WriteUpdatedBase(const BaseDelta& delta, const SerializationSettings& serialization_settings);
+
+bool UpdateTransportCatalogue(const BaseDelta& delta, const SerializationSettings& serialization_settings) {
+	try {
+		return WriteUpdatedBase(delta, serialization_settings);
+	}
+	catch (const logic_error& e) {
+		cerr << e.what() << '\n';
+		return false;
+	}
+}
+
+bool WriteUpdatedBase(const BaseDelta& delta, const SerializationSettings& serialization_settings) {
+
+	serialize::TransportCatalogue serialize_transport;
+	routing::Attrs routing_attrs;
+	transport::TransportCatalogue transport;
+	optional<TransportRouter> transport_router;
+
+	// The previous base, which may be mapped from the file being written, is released before writing
+	{
+		filesystem::path base_file = delta.base_file;
+		transport::TransportCatalogue previous_transport;
+		InputAttrs attrs;
+		optional<TransportRouter> previous_router;
+
+		if (!DeserializeTransportCatalogue(base_file, previous_transport, attrs, previous_router, BaseParts{})) {
+			return false;
+		}
+		routing_attrs = attrs.routing_attrs;
+
+		WriteBaseRequests(previous_transport, serialize_transport);
+		WriteRenderSettings(attrs.render_attrs, *serialize_transport.mutable_render_settings());
+		WriteRoutingSettings(routing_attrs, *serialize_transport.mutable_routing_settings());
+		ApplyBaseDelta(delta, serialize_transport);
+
+		// Kept stops keep their order, so vertex ids only shift down past the removed ones
+		unordered_set<string_view> stop_names;
+		for (auto& stop_data : serialize_transport.stops_data()) {
+			stop_names.insert(stop_data.name());
+		}
+		vector<optional<VertexId>> vertex_ids(previous_transport.GetStopsCount());
+
+		for (transport::StopId stop_id = 0; stop_id < previous_transport.GetStopsCount(); ++stop_id) {
+
+			const string_view stop_name = previous_transport.GetStopName(stop_id);
+
+			if (stop_names.count(stop_name) != 0 || find(delta.removed_stops.begin(), delta.removed_stops.end(), stop_name)
+													== delta.removed_stops.end()) {
+				vertex_ids[stop_id] = transport.AddStopName(stop_name);
+			}
+		}
+		ReadTransportBase(serialize_transport, transport);
+
+		// The graph is rebuilt from the catalogue, which is linear in the edge count
+		routing::Attrs graph_attrs = routing_attrs;
+		graph_attrs.router_mode = RouterMode::ON_DEMAND;
+		const TransportRouter graph_router{ transport, graph_attrs };
+
+		TransportGraph graph = graph_router.GetGraph();
+		vector<EdgeInfo> edge_infos;
+		edge_infos.reserve(graph.GetEdgeCount());
+
+		for (graph::EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+			edge_infos.push_back(graph_router.GetEdgeInfo(edge_id));
+		}
+
+		optional<TransportRoutesData> routes_data;
+
+		// Ride vertices are numbered along the bus paths, so a table of the stop-bus graph is computed again
+		if (routing_attrs.router_mode == RouterMode::PRECOMPUTED && routing_attrs.graph_model == GraphModel::SPANS) {
+			routes_data = UpdateRoutesData(graph, previous_router->GetRouter().GetRoutesInternalData(), vertex_ids,
+										   MatchEdges(previous_transport, *previous_router, transport, graph_router));
+		}
+		// A contraction hierarchy is built again from the new graph
+		transport_router.emplace(transport, routing_attrs, move(graph), move(edge_infos), move(routes_data), nullopt);
+	}
+	return WriteTransportCatalogue(transport, serialize_transport, routing_attrs, *transport_router, serialization_settings);
+}
+
+// Base requests which make the catalogue again: the stops with their explicitly given road distances and the buses
+void WriteBaseRequests(const transport::TransportCatalogue& transport, serialize::TransportCatalogue& serialize_transport) {
+
+	vector<serialize::StopData*> stops_data(transport.GetStopsCount(), nullptr);
+
+	for (transport::StopId stop_id = 0; stop_id < transport.GetStopsCount(); ++stop_id) {
+
+		if (const transport::StopData* stop = transport.GetStopData(stop_id)) {
+
+			serialize::StopData* stop_data = serialize_transport.add_stops_data();
+			stop_data->set_name(string(transport.GetStopName(stop_id)));
+			stop_data->set_latitude(stop->GetCoordinates().lat);
+			stop_data->set_longitude(stop->GetCoordinates().lng);
+			stops_data[stop_id] = stop_data;
+		}
+	}
+
+	transport.GetDistances().ForEachExplicit([&transport, &stops_data](transport::StopId stop_from, transport::StopId stop_to,
+																		 size_t distance) {
+		if (stops_data[stop_from]) {
+			auto road_distance = stops_data[stop_from]->add_road_distances();
+			road_distance->set_stop_name(string(transport.GetStopName(stop_to)));
+			road_distance->set_distance(static_cast<int32_t>(distance));
+		}
+	});
+
+	for (transport::BusId bus_id = 0; bus_id < transport.GetBusesCount(); ++bus_id) {
+
+		serialize::BusData* bus_data = serialize_transport.add_buses_data();
+		bus_data->set_name(string(transport.GetBusName(bus_id)));
+		bus_data->set_is_roundtrip(transport.GetBusData(bus_id).IsRing());
+
+		for (transport::StopId stop_id : transport.GetBusPath(bus_id)) {
+			bus_data->add_stops(string(transport.GetStopName(stop_id)));
+		}
+	}
+}
+
+template <typename Data>
+void RemoveByName(google::protobuf::RepeatedPtrField<Data>& data, const string& name, const string& kind) {
+
+	auto it = find_if(data.begin(), data.end(), [&name](const Data& item) { return item.name() == name; });
+
+	if (it == data.end()) {
+		throw invalid_argument("Unknown "s + kind + " in the base delta: "s + name);
+	}
+	data.erase(it);
+}
+
+template <typename Data>
+void ReplaceByName(google::protobuf::RepeatedPtrField<Data>& data, const Data& item) {
+
+	auto it = find_if(data.begin(), data.end(), [&item](const Data& stored) { return stored.name() == item.name(); });
+
+	if (it == data.end()) {
+		*data.Add() = item;
+	}
+	else {
+		*it = item;
+	}
+}
+
+void ApplyBaseDelta(const BaseDelta& delta, serialize::TransportCatalogue& serialize_transport) {
+
+	auto& stops = *serialize_transport.mutable_stops_data();
+	auto& buses = *serialize_transport.mutable_buses_data();
+
+	for (const string& bus_name : delta.removed_buses) {
+		RemoveByName(buses, bus_name, "bus"s);
+	}
+	for (const string& stop_name : delta.removed_stops) {
+
+		RemoveByName(stops, stop_name, "stop"s);
+
+		for (auto& stop_data : stops) {
+
+			auto& road_distances = *stop_data.mutable_road_distances();
+			road_distances.erase(remove_if(road_distances.begin(), road_distances.end(),
+										   [&stop_name](const serialize::RoadDistance& road_distance) {
+											   return road_distance.stop_name() == stop_name; }),
+								 road_distances.end());
+		}
+	}
+	for (auto& stop_data : delta.changes.stops_data()) {
+		ReplaceByName(stops, stop_data);
+	}
+	for (auto& bus_data : delta.changes.buses_data()) {
+		ReplaceByName(buses, bus_data);
+	}
+
+	unordered_set<string_view> stop_names;
+	for (auto& stop_data : stops) {
+		stop_names.insert(stop_data.name());
+	}
+	for (auto& bus_data : buses) {
+		for (auto& stop : bus_data.stops()) {
+			if (stop_names.count(stop) == 0) {
+				throw invalid_argument("Bus "s + bus_data.name() + " stops at an unknown stop: "s + stop);
+			}
+		}
+	}
+}
+
+// An edge is kept if the changed graph has an edge of the same bus between the same stops with the
+// same span count and weight; the routes through it stay the same. Unmatched edges are nullopt.
+vector<optional<graph::EdgeId>> MatchEdges(const transport::TransportCatalogue& previous_transport,
+										   const TransportRouter& previous_router,
+										   const transport::TransportCatalogue& transport, const TransportRouter& transport_router) {
+
+	using EdgeKey = tuple<transport::BusId, VertexId, VertexId, int, double>;
+
+	auto get_key = [](const TransportRouter& router, graph::EdgeId edge_id, transport::BusId bus_id,
+					  VertexId vertex_from, VertexId vertex_to) {
+		return EdgeKey{ bus_id, vertex_from, vertex_to, router.GetEdgeInfo(edge_id).span_count, router.GetEdgeWeight(edge_id) };
+	};
+
+	const TransportGraph& graph = transport_router.GetGraph();
+	vector<pair<EdgeKey, graph::EdgeId>> edges;
+	edges.reserve(graph.GetEdgeCount());
+
+	for (graph::EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+		const TransportEdge& edge = graph.GetEdge(edge_id);
+		edges.emplace_back(get_key(transport_router, edge_id, transport_router.GetEdgeInfo(edge_id).bus_id, edge.from, edge.to),
+						   edge_id);
+	}
+	sort(edges.begin(), edges.end());
+
+	const TransportGraph& previous_graph = previous_router.GetGraph();
+	vector<optional<graph::EdgeId>> edge_ids(previous_graph.GetEdgeCount());
+	vector<bool> is_matched(edges.size(), false);
+
+	for (graph::EdgeId previous_id = 0; previous_id < previous_graph.GetEdgeCount(); ++previous_id) {
+
+		const TransportEdge& edge = previous_graph.GetEdge(previous_id);
+		const optional<transport::BusId> bus_id = transport.FindBusId(
+			previous_transport.GetBusName(previous_router.GetEdgeInfo(previous_id).bus_id));
+		const optional<transport::StopId> stop_from = transport.FindStopId(previous_transport.GetStopName(edge.from));
+		const optional<transport::StopId> stop_to = transport.FindStopId(previous_transport.GetStopName(edge.to));
+
+		if (!bus_id || !stop_from || !stop_to) {
+			continue;
+		}
+		const EdgeKey key = get_key(previous_router, previous_id, *bus_id, transport_router.GetVertexId(*stop_from),
+									transport_router.GetVertexId(*stop_to));
+
+		for (auto it = lower_bound(edges.begin(), edges.end(), make_pair(key, graph::EdgeId{ 0 }));
+			 it != edges.end() && it->first == key; ++it) {
+
+			if (!is_matched[it - edges.begin()]) {
+				is_matched[it - edges.begin()] = true;
+				edge_ids[previous_id] = it->second;
+				break;
+			}
+		}
+	}
+	return edge_ids;
+}
+
+bool ReadBaseStopNames(const serialize::StopNames& stop_names, transport::TransportCatalogue& transport);
+bool ReadBaseStopData(const serialize::StopData& stop_data, const BaseParts& parts, transport::TransportCatalogue& transport);
+bool ReadBaseBusData(const serialize::BusData& bus_data, const BaseParts& parts, transport::TransportCatalogue& transport);
+bool ReadTransportRoutesData(ZeroCopyInputStream& input, const serialize::BaseHeader& header, const BaseSection& section,
+							 TransportRoutesData& routes_data);
+bool ReadTransportGraph(ZeroCopyInputStream& input, const serialize::BaseHeader& header, const BaseSection& section,
+						TransportGraph& graph, vector<EdgeInfo>& edge_infos);
+bool ReadTransportHierarchy(ZeroCopyInputStream& input, const serialize::BaseHeader& header, const BaseSection& section,
+							TransportHierarchy& hierarchy);
+bool ReadProtobufBase(const filesystem::path& serialize_result_path, transport::TransportCatalogue& transport,
+					  InputAttrs& attrs, optional<routing::TransportRouter>& router, const BaseParts& parts);
+
+bool DeserializeTransportCatalogue(filesystem::path& serialize_result_path, transport::TransportCatalogue& transport,
+									InputAttrs& attrs, optional<routing::TransportRouter>& router,
+									const BaseParts& parts) {
+
+	// A base whose checksums match may still hold a graph, routes table or hierarchy
+	// which the router rejects by throwing
+	try {
+		if (IsMappedBase(serialize_result_path)) {
+			return ReadMappedBase(serialize_result_path, transport, attrs, router, parts);
+		}
+		return ReadProtobufBase(serialize_result_path, transport, attrs, router, parts);
+	}
+	catch (const exception&) {
+		router.reset();
+		return false;
+	}
+}
+
+bool ReadProtobufBase(const filesystem::path& serialize_result_path, transport::TransportCatalogue& transport,
+					  InputAttrs& attrs, optional<routing::TransportRouter>& router, const BaseParts& parts) {
+
+	using google::protobuf::util::ParseDelimitedFromZeroCopyStream;
+
+	ifstream ifs{ serialize_result_path, ios::binary };
+	BaseFileHeader file_header;
+	error_code error;
+	const uintmax_t file_size = filesystem::file_size(serialize_result_path, error);
+
+	if (!ReadFileHeader(ifs, file_header) || error || file_header.catalogue.size > numeric_limits<int>::max()
+		|| file_size != BASE_FILE_HEADER_SIZE + file_header.catalogue.size + file_header.graph.size + file_header.routes.size) {
+		return false;
+	}
+
+	string catalogue(file_header.catalogue.size, '\0');
+
+	if (!ifs.read(catalogue.data(), catalogue.size())
+		|| ComputeSectionChecksums({ { catalogue.data(), catalogue.size() } }).front() != file_header.catalogue.checksum) {
+		return false;
+	}
+	google::protobuf::io::ArrayInputStream catalogue_input{ catalogue.data(), static_cast<int>(catalogue.size()) };
+
+	serialize::BaseHeader header;
+	serialize::StopNames stop_names;
+
+	if (!ParseDelimitedFromZeroCopyStream(&header, &catalogue_input, nullptr)
+		|| !ParseDelimitedFromZeroCopyStream(&stop_names, &catalogue_input, nullptr)
+		|| !ReadBaseStopNames(stop_names, transport)) {
+		return false;
+	}
+	for (uint32_t index = 0; index < header.stop_count(); ++index) {
+
+		serialize::StopData stop_data;
+
+		if (!ParseDelimitedFromZeroCopyStream(&stop_data, &catalogue_input, nullptr)
+			|| !ReadBaseStopData(stop_data, parts, transport)) {
+			return false;
+		}
+	}
+	for (uint32_t index = 0; index < header.bus_count(); ++index) {
+
+		serialize::BusData bus_data;
+
+		if (!ParseDelimitedFromZeroCopyStream(&bus_data, &catalogue_input, nullptr)
+			|| !ReadBaseBusData(bus_data, parts, transport)) {
+			return false;
+		}
+	}
+
+	serialize::BaseSettings settings;
+
+	if (!ParseDelimitedFromZeroCopyStream(&settings, &catalogue_input, nullptr)
+		|| static_cast<uint64_t>(catalogue_input.ByteCount()) != catalogue.size()) {
+		return false;
+	}
+	if (parts.render_settings) {
+		ReadRenderSettings(*settings.mutable_render_settings(), attrs.render_attrs);
+	}
+	// The routes come last, so the rest of the file is not read without them
+	if (parts.routes) {
+
+		ReadRoutingSettings(settings.routing_settings(), attrs.routing_attrs);
+
+		google::protobuf::io::IstreamInputStream input{ &ifs };
+		TransportGraph graph;
+		vector<EdgeInfo> edge_infos;
+		optional<TransportRoutesData> routes_data;
+		optional<TransportHierarchy> hierarchy;
+
+		if (!ReadTransportGraph(input, header, file_header.graph, graph, edge_infos)) {
+			return false;
+		}
+		if (attrs.routing_attrs.router_mode == RouterMode::PRECOMPUTED
+			&& !ReadTransportRoutesData(input, header, file_header.routes, routes_data.emplace())) {
+			return false;
+		}
+		if (attrs.routing_attrs.router_mode == RouterMode::CONTRACTED
+			&& !ReadTransportHierarchy(input, header, file_header.routes, hierarchy.emplace())) {
+			return false;
+		}
+		router.emplace(transport, attrs.routing_attrs, move(graph), move(edge_infos), move(routes_data), move(hierarchy));
+	}
+	return true;
+}
+
+// Prev edge ids are stored plus 2, so the two sentinels at the top of the range
+// wrap around to 0 (unreachable) and 1 (no edge) and take a single varint byte
+uint32_t EncodePrevEdge(TransportRoutesData::PrevEdge prev_edge) {
+	return static_cast<uint32_t>(prev_edge + 2);
+}
+
+TransportRoutesData::PrevEdge DecodePrevEdge(uint32_t code) {
+	return static_cast<TransportRoutesData::PrevEdge>(code - 2);
+}
+
+// A compressed block starts with the varint size of the message, so it is inflated into
+// a buffer of the right size in one call. Level 1 keeps make_base fast; the blocks are
+// regular enough for it to get most of the gain.
+bool CompressBlock(const string& bytes, string& compressed) {
+
+	uLongf compressed_size = compressBound(static_cast<uLong>(bytes.size()));
+	compressed.resize(10 + compressed_size);
+
+	uint8_t* data = reinterpret_cast<uint8_t*>(compressed.data());
+	uint8_t* data_end = google::protobuf::io::CodedOutputStream::WriteVarint64ToArray(bytes.size(), data);
+
+	if (compress2(data_end, &compressed_size, reinterpret_cast<const Bytef*>(bytes.data()),
+				  static_cast<uLong>(bytes.size()), Z_BEST_SPEED) != Z_OK) {
+		return false;
+	}
+	compressed.resize(static_cast<size_t>(data_end - data) + compressed_size);
+	return true;
+}
+
+// The size stored in front of the block is not trusted beyond max_size
+bool DecompressBlock(const string& compressed, size_t max_size, string& bytes) {
+
+	google::protobuf::io::CodedInputStream coded_input{ reinterpret_cast<const uint8_t*>(compressed.data()),
+														static_cast<int>(compressed.size()) };
+	uint64_t size = 0;
+
+	if (!coded_input.ReadVarint64(&size) || size > max_size || size > numeric_limits<uLong>::max()) {
+		return false;
+	}
+	const size_t header_size = static_cast<size_t>(coded_input.CurrentPosition());
+	bytes.resize(size);
+
+	uLongf bytes_size = static_cast<uLongf>(size);
+
+	return uncompress(reinterpret_cast<Bytef*>(bytes.data()), &bytes_size,
+					  reinterpret_cast<const Bytef*>(compressed.data() + header_size),
+					  static_cast<uLong>(compressed.size() - header_size)) == Z_OK
+		&& bytes_size == size;
+}
+
+// Writes the block as the little-endian 64-bit checksum of its payload followed by the
+// length-delimited payload, and adds the checksum to those of the section
+bool WriteBlock(const google::protobuf::MessageLite& block, serialize::BlockCodec codec, ZeroCopyOutputStream& output,
+				vector<uint64_t>& checksums) {
+
+	string payload = block.SerializeAsString();
+
+	if (codec != serialize::CODEC_NONE) {
+
+		string compressed;
+
+		if (!CompressBlock(payload, compressed)) {
+			return false;
+		}
+		payload = move(compressed);
+	}
+	checksums.push_back(ComputeChecksum(payload.data(), payload.size()));
+
+	google::protobuf::io::CodedOutputStream coded_output{ &output };
+	coded_output.WriteLittleEndian64(checksums.back());
+	coded_output.WriteVarint32(static_cast<uint32_t>(payload.size()));
+	coded_output.WriteString(payload);
+	return !coded_output.HadError();
+}
+
+// The edges are written in id order as consecutive blocks of block_size edges
+bool WriteTransportGraph(const TransportRouter& transport_router, size_t block_size, serialize::BlockCodec codec,
+						 ZeroCopyOutputStream& output, BaseSection& section) {
+
+	const TransportGraph& graph = transport_router.GetGraph();
+	const size_t edge_count = graph.GetEdgeCount();
+	const int64_t section_begin = output.ByteCount();
+	vector<uint64_t> checksums;
+
+	for (size_t block_begin = 0; block_begin < edge_count; block_begin += block_size) {
+
+		serialize::EdgesBlock serialize_block;
+
+		for (graph::EdgeId edge_id = block_begin; edge_id < min(block_begin + block_size, edge_count); ++edge_id) {
+
+			const TransportEdge& edge = graph.GetEdge(edge_id);
+			const EdgeInfo& edge_info = transport_router.GetEdgeInfo(edge_id);
+
+			serialize_block.add_vertices_from(static_cast<uint32_t>(edge.from));
+			serialize_block.add_vertices_to(static_cast<uint32_t>(edge.to));
+			serialize_block.add_weights(edge.weight);
+			serialize_block.add_bus_ids(edge_info.bus_id);
+			serialize_block.add_span_counts(static_cast<uint32_t>(edge_info.span_count));
+		}
+
+		if (!WriteBlock(serialize_block, codec, output, checksums)) {
+			return false;
+		}
+	}
+	section = BaseSection{ static_cast<uint64_t>(output.ByteCount() - section_begin), CombineChecksums(checksums) };
+	return true;
+}
+
+// The table is written as consecutive blocks of block_rows rows, each a separate message
+bool WriteTransportRoutesData(const TransportRoutesData& routes_data, size_t block_rows, serialize::BlockCodec codec,
+							  ZeroCopyOutputStream& output, BaseSection& section) {
+
+	const size_t vertex_count = routes_data.GetVertexCount();
+	const int64_t section_begin = output.ByteCount();
+	vector<uint64_t> checksums;
+
+	for (size_t row_begin = 0; row_begin < vertex_count; row_begin += block_rows) {
+
+		const size_t cell_begin = row_begin * vertex_count;
+		const size_t cell_end = min(row_begin + block_rows, vertex_count) * vertex_count;
+
+		serialize::RoutesBlock serialize_block;
+		serialize_block.mutable_weights()->Add(routes_data.GetWeights() + cell_begin, routes_data.GetWeights() + cell_end);
+
+		auto serialize_prev_edges = serialize_block.mutable_prev_edges();
+		serialize_prev_edges->Reserve(static_cast<int>(cell_end - cell_begin));
+
+		for (const TransportRoutesData::PrevEdge* prev_edge = routes_data.GetPrevEdges() + cell_begin;
+			 prev_edge != routes_data.GetPrevEdges() + cell_end; ++prev_edge) {
+			serialize_prev_edges->AddAlreadyReserved(EncodePrevEdge(*prev_edge));
+		}
+
+		if (!WriteBlock(serialize_block, codec, output, checksums)) {
+			return false;
+		}
+	}
+	section = BaseSection{ static_cast<uint64_t>(output.ByteCount() - section_begin), CombineChecksums(checksums) };
+	return true;
+}
+
+// Vertex ranks and shortcuts are written side by side, block_size of each per block
+bool WriteTransportHierarchy(const TransportHierarchy& hierarchy, size_t vertex_count, size_t block_size,
+							 serialize::BlockCodec codec, ZeroCopyOutputStream& output, BaseSection& section) {
+
+	const size_t shortcut_count = hierarchy.shortcuts.size();
+	const int64_t section_begin = output.ByteCount();
+	vector<uint64_t> checksums;
+
+	for (size_t block_begin = 0; block_begin < max(vertex_count, shortcut_count); block_begin += block_size) {
+
+		serialize::HierarchyBlock serialize_block;
+
+		for (VertexId vertex = block_begin; vertex < min(block_begin + block_size, vertex_count); ++vertex) {
+			serialize_block.add_vertex_ranks(static_cast<uint32_t>(hierarchy.ranks[vertex]));
+		}
+		for (size_t index = block_begin; index < min(block_begin + block_size, shortcut_count); ++index) {
+
+			const auto& shortcut = hierarchy.shortcuts[index];
+
+			serialize_block.add_vertices_from(static_cast<uint32_t>(shortcut.from));
+			serialize_block.add_vertices_to(static_cast<uint32_t>(shortcut.to));
+			serialize_block.add_weights(shortcut.weight);
+			serialize_block.add_first_edges(static_cast<uint32_t>(shortcut.first_edge));
+			serialize_block.add_second_edges(static_cast<uint32_t>(shortcut.second_edge));
+		}
+
+		if (!WriteBlock(serialize_block, codec, output, checksums)) {
+			return false;
+		}
+	}
+	section = BaseSection{ static_cast<uint64_t>(output.ByteCount() - section_begin), CombineChecksums(checksums) };
+	return true;
+}
+
+void ReadStopData(const serialize::StopData& stop_data, transport::TransportCatalogue& transport);
+void ReadBusData(const serialize::BusData& bus_data, transport::TransportCatalogue& transport);
+
+void ReadTransportBase(const serialize::TransportCatalogue &serialize_transport, transport::TransportCatalogue& transport) {
+
+	auto& stops = serialize_transport.stops_data();
+	auto& buses = serialize_transport.buses_data();
+
+	for (auto& stop_data : stops) {
+		ReadStopData(stop_data, transport);
+	}
+	for (auto& bus_data : buses) {
+		ReadBusData(bus_data, transport);
+	}
+}
+
+svg::Color GetColor(serialize::Color& color);
+svg::Point GetPoint(const serialize::Point& point);
+void SetColor(const svg::Color& color, serialize::Color& serialize_color);
+void SetPoint(const svg::Point& point, serialize::Point& serialize_point);
+
+void WriteRenderSettings(const renderer::Attrs& render_attrs, serialize::RenderSettings& render_settings) {
+
+	render_settings.set_map_width(render_attrs.map_width);
+	render_settings.set_map_height(render_attrs.map_height);
+	render_settings.set_map_padding(render_attrs.map_padding);
+	render_settings.set_stop_radius(render_attrs.stop_radius);
+	render_settings.set_line_width(render_attrs.line_width);
+	render_settings.set_bus_label_font_size(render_attrs.bus_label_font_size);
+	render_settings.set_stop_label_font_size(render_attrs.stop_label_font_size);
+	render_settings.set_underlayer_width(render_attrs.underlayer_width);
+
+	SetPoint(render_attrs.bus_label_offset, *render_settings.mutable_bus_label_offset());
+	SetPoint(render_attrs.stop_label_offset, *render_settings.mutable_stop_label_offset());
+	SetColor(render_attrs.underlayer_color, *render_settings.mutable_underlayer_color());
+
+	for (const svg::Color& color : render_attrs.stroke_colors) {
+		SetColor(color, *render_settings.add_stroke_colors());
+	}
+}
+
+void ReadRenderSettings(serialize::RenderSettings& render_settings, renderer::Attrs& render_attrs) {
+
+	render_attrs.map_width = render_settings.map_width();
+	render_attrs.map_height = render_settings.map_height();
+	render_attrs.map_padding = render_settings.map_padding();
+	render_attrs.stop_radius = render_settings.stop_radius();
+	render_attrs.line_width = render_settings.line_width();
+	render_attrs.bus_label_font_size = render_settings.bus_label_font_size();
+	render_attrs.stop_label_font_size = render_settings.stop_label_font_size();
+	render_attrs.underlayer_width = render_settings.underlayer_width();
+
+	render_attrs.bus_label_offset = GetPoint(render_settings.bus_label_offset());
+	render_attrs.stop_label_offset = GetPoint(render_settings.stop_label_offset());
+	render_attrs.underlayer_color = GetColor(*render_settings.mutable_underlayer_color());
+
+	for (auto& color : *render_settings.mutable_stroke_colors()) {
+		render_attrs.stroke_colors.push_back(GetColor(color));
+	}
+}
+
+void ReadStopData(const serialize::StopData& stop_data, transport::TransportCatalogue& transport) {
+
+	double lat = stop_data.latitude();
+	double lng = stop_data.longitude();
+
+	const transport::StopId stop_id = transport.AddStopName(stop_data.name());
+	transport.AddStop(stop_data.name(), transport::StopData{ geo::Coordinates{ lat, lng } });
+
+	for (auto& road_distance : stop_data.road_distances()) {
+		transport.SetDistance(stop_id, transport.AddStopName(road_distance.stop_name()), road_distance.distance());
+	}
+}
+
+void ReadBusData(const serialize::BusData& bus_data, transport::TransportCatalogue& transport) {
+
+	bool  path_is_ring = bus_data.is_roundtrip();
+	string bus_name = bus_data.name();
+
+	vector<transport::StopId> bus_path;
+
+	auto& stops = bus_data.stops();
+	bus_path.reserve(stops.size());
+
+	for (auto& stop : stops) {
+		bus_path.push_back(transport.AddStopName(stop));
+	}
+	const transport::BusId bus_id = transport.AddBus(move(bus_name), move(bus_path), path_is_ring);
+	transport.SetBusStats(bus_id, transport.ComputeBusStats(bus_id));
+}
+
+// Stop ids are the indices in the table, as they were in make_base
+bool ReadBaseStopNames(const serialize::StopNames& stop_names, transport::TransportCatalogue& transport) {
+
+	for (const string& name : stop_names.names()) {
+		if (transport.AddStopName(name) != transport.GetStopsCount() - 1) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ReadBaseStopData(const serialize::StopData& stop_data, const BaseParts& parts, transport::TransportCatalogue& transport) {
+
+	const size_t stop_count = transport.GetStopsCount();
+
+	if (stop_data.id() >= stop_count) {
+		return false;
+	}
+	if (parts.stops) {
+		transport.AddStop(stop_data.id(), transport::StopData{ geo::Coordinates{ stop_data.latitude(), stop_data.longitude() } });
+	}
+	if (parts.road_distances) {
+
+		for (auto& road_distance : stop_data.road_distances()) {
+
+			if (road_distance.stop_id() >= stop_count) {
+				return false;
+			}
+			transport.SetDistance(stop_data.id(), road_distance.stop_id(), road_distance.distance());
+		}
+	}
+	return true;
+}
+
+bool ReadBaseBusData(const serialize::BusData& bus_data, const BaseParts& parts, transport::TransportCatalogue& transport) {
+
+	vector<transport::StopId> bus_path;
+
+	if (parts.bus_paths) {
+
+		bus_path.assign(bus_data.stop_ids().begin(), bus_data.stop_ids().end());
+
+		for (transport::StopId stop_id : bus_path) {
+			if (stop_id >= transport.GetStopsCount()) {
+				return false;
+			}
+		}
+	}
+	const transport::BusId bus_id = transport.AddBus(string(bus_data.name()), move(bus_path), bus_data.is_roundtrip());
+
+	auto& stats = bus_data.stats();
+	transport.SetBusStats(bus_id, transport::BusStats{ stats.stop_count(), stats.unique_stop_count(),
+													   stats.route_length(), stats.geo_length() });
+	return true;
+}
+
+void WriteBusStats(const transport::TransportCatalogue& transport, serialize::TransportCatalogue& serialize_transport) {
+
+	for (auto& bus_data : *serialize_transport.mutable_buses_data()) {
+
+		const transport::BusStats stats = transport.ComputeBusStats(*transport.FindBusId(bus_data.name()));
+
+		auto serialize_stats = bus_data.mutable_stats();
+		serialize_stats->set_stop_count(static_cast<uint32_t>(stats.stop_count));
+		serialize_stats->set_unique_stop_count(static_cast<uint32_t>(stats.unique_stop_count));
+		serialize_stats->set_route_length(stats.route_length);
+		serialize_stats->set_geo_length(stats.geo_length);
+	}
+}
+
+// Replaces stop names with stop ids in the stops and buses written to the base file
+void WriteStopIds(const transport::TransportCatalogue& transport, serialize::TransportCatalogue& serialize_transport) {
+
+	for (auto& stop_data : *serialize_transport.mutable_stops_data()) {
+
+		stop_data.set_id(*transport.FindStopId(stop_data.name()));
+		stop_data.clear_name();
+
+		for (auto& road_distance : *stop_data.mutable_road_distances()) {
+			road_distance.set_stop_id(*transport.FindStopId(road_distance.stop_name()));
+			road_distance.clear_stop_name();
+		}
+	}
+	for (auto& bus_data : *serialize_transport.mutable_buses_data()) {
+
+		for (auto& stop : bus_data.stops()) {
+			bus_data.add_stop_ids(*transport.FindStopId(stop));
+		}
+		bus_data.clear_stops();
+	}
+}
+
+void WriteRoutingSettings(const routing::Attrs& routing_attrs, serialize::RoutingSettings& routing_settings) {
+
+	routing_settings.set_bus_velocity(routing_attrs.bus_velocity);
+	routing_settings.set_bus_wait_time(routing_attrs.bus_wait_time);
+	switch (routing_attrs.router_mode) {
+	case RouterMode::ON_DEMAND:
+		routing_settings.set_router_mode(serialize::ON_DEMAND);
+		break;
+	case RouterMode::CONTRACTED:
+		routing_settings.set_router_mode(serialize::CONTRACTED);
+		break;
+	default:
+		routing_settings.set_router_mode(serialize::PRECOMPUTED);
+	}
+	routing_settings.set_graph_model(routing_attrs.graph_model == GraphModel::STOP_BUS ? serialize::STOP_BUS
+																						 : serialize::SPANS);
+}
+
+void ReadRoutingSettings(const serialize::RoutingSettings& routing_settings, routing::Attrs& routing_attrs) {
+
+	routing_attrs.bus_velocity = routing_settings.bus_velocity();
+	routing_attrs.bus_wait_time = routing_settings.bus_wait_time();
+
+	if (routing_settings.router_mode() == serialize::ON_DEMAND) {
+		routing_attrs.router_mode = RouterMode::ON_DEMAND;
+	}
+	else if (routing_settings.router_mode() == serialize::CONTRACTED) {
+		routing_attrs.router_mode = RouterMode::CONTRACTED;
+	}
+	else {
+		routing_attrs.router_mode = RouterMode::PRECOMPUTED;
+	}
+	routing_attrs.graph_model = routing_settings.graph_model() == serialize::STOP_BUS ? GraphModel::STOP_BUS
+																					  : GraphModel::SPANS;
+}
+
+svg::Color GetColor(serialize::Color& color) {
+	if (!color.color_str().empty()) {
+		return move(*color.mutable_color_str());
+	}
+	else {
+		uint8_t red = static_cast<uint8_t>(color.red());
+		uint8_t green = static_cast<uint8_t>(color.green());
+		uint8_t blue = static_cast<uint8_t>(color.blue());
+
+		if (!color.has_opacity()) {
+			return svg::Rgb(red, green, blue);
+		}
+		else {
+			double opacity = color.opacity().value();
+			return svg::Rgba(red, green, blue, opacity);
+		}
+	}
+}
+
+svg::Point GetPoint(const serialize::Point& point) {
+	return svg::Point{ point.x(), point.y() };
+}
+
+void SetColor(const svg::Color& color, serialize::Color& serialize_color) {
+	if (const string* color_str = get_if<string>(&color)) {
+		serialize_color.set_color_str(*color_str);
+	}
+	else if (const svg::Rgb* rgb = get_if<svg::Rgb>(&color)) {
+		serialize_color.set_red(rgb->red);
+		serialize_color.set_green(rgb->green);
+		serialize_color.set_blue(rgb->blue);
+	}
+	else if (const svg::Rgba* rgba = get_if<svg::Rgba>(&color)) {
+		serialize_color.set_red(rgba->red);
+		serialize_color.set_green(rgba->green);
+		serialize_color.set_blue(rgba->blue);
+		serialize_color.mutable_opacity()->set_value(rgba->opacity);
+	}
+}
+
+void SetPoint(const svg::Point& point, serialize::Point& serialize_point) {
+	serialize_point.set_x(point.x);
+	serialize_point.set_y(point.y);
+}
+
+// Upper bound of the serialized size of a block of item_count items (table cells, edges,
+// or vertex ranks with shortcuts), none of which takes more than 64 bytes
+size_t GetMaxBlockSize(size_t item_count) {
+	constexpr size_t MAX_ITEM_SIZE = 64;
+	constexpr size_t MAX_BLOCK_OVERHEAD = 1024;
+	return item_count > (numeric_limits<size_t>::max() - MAX_BLOCK_OVERHEAD) / MAX_ITEM_SIZE
+		? numeric_limits<size_t>::max() : item_count * MAX_ITEM_SIZE + MAX_BLOCK_OVERHEAD;
+}
+
+// Reads block_count blocks of the section in file order, then checks, decompresses and
+// decodes them on worker threads with decode(block_index, bytes). A block is only
+// decompressed and parsed once its payload matches the checksum stored in front of it.
+// Blocks are read in waves of a few per thread, so no more than one wave of raw bytes is
+// held at a time. The section size and checksum are compared once all blocks are read. A decompressed
+// block may not exceed max_block_size bytes; a block which fails to decode in any way,
+// exceptions included, fails the section.
+template <typename Decode>
+bool ReadBlocksInParallel(ZeroCopyInputStream& input, size_t block_count, serialize::BlockCodec codec,
+						  size_t max_block_size, const BaseSection& section, Decode decode) {
+
+	if (codec != serialize::CODEC_NONE && codec != serialize::CODEC_ZLIB) {
+		return false;
+	}
+
+	const int64_t section_begin = input.ByteCount();
+	vector<uint64_t> checksums(block_count);
+
+	const size_t wave_size = max(1u, thread::hardware_concurrency()) * 2;
+	vector<string> blocks;
+	vector<uint64_t> stored_checksums;
+	vector<char> decoded;
+
+	for (size_t wave_begin = 0; wave_begin < block_count; wave_begin += wave_size) {
+
+		blocks.resize(min(wave_size, block_count - wave_begin));
+		stored_checksums.resize(blocks.size());
+
+		for (size_t index = 0; index < blocks.size(); ++index) {
+
+			google::protobuf::io::CodedInputStream coded_input{ &input };
+			uint32_t size = 0;
+
+			if (!coded_input.ReadLittleEndian64(&stored_checksums[index]) || !coded_input.ReadVarint32(&size)
+				|| !coded_input.ReadString(&blocks[index], static_cast<int>(size))) {
+				return false;
+			}
+		}
+
+		decoded.assign(blocks.size(), false);
+		ParallelFor(blocks.size(), [&decoded, &blocks, &stored_checksums, &checksums, &decode, codec, max_block_size,
+									wave_begin](size_t index) {
+
+			checksums[wave_begin + index] = ComputeChecksum(blocks[index].data(), blocks[index].size());
+
+			if (checksums[wave_begin + index] != stored_checksums[index]) {
+				return;
+			}
+			try {
+				if (codec == serialize::CODEC_NONE) {
+					decoded[index] = decode(wave_begin + index, blocks[index]);
+					return;
+				}
+				string bytes;
+				decoded[index] = DecompressBlock(blocks[index], max_block_size, bytes) && decode(wave_begin + index, bytes);
+			}
+			catch (const exception&) {
+				decoded[index] = false;
+			}
+		});
+
+		if (find(decoded.begin(), decoded.end(), false) != decoded.end()) {
+			return false;
+		}
+	}
+	return static_cast<uint64_t>(input.ByteCount() - section_begin) == section.size
+		&& CombineChecksums(checksums) == section.checksum;
+}
+
+bool ReadTransportRoutesData(ZeroCopyInputStream& input, const serialize::BaseHeader& header, const BaseSection& section,
+							 TransportRoutesData& routes_data) {
+
+	const size_t vertex_count = header.vertex_count();
+	const size_t block_rows = header.routes_block_rows();
+	const size_t cell_count = vertex_count * vertex_count;
+
+	if (vertex_count != 0 && block_rows == 0) {
+		return false;
+	}
+
+	vector<double> weights(cell_count);
+	vector<TransportRoutesData::PrevEdge> prev_edges(cell_count);
+
+	// Every block fills its own rows of the table, so blocks are decoded independently
+	auto decode_block = [&weights, &prev_edges, vertex_count, block_rows](size_t block_index, const string& bytes) {
+
+		const size_t row_begin = block_index * block_rows;
+		const size_t cell_begin = row_begin * vertex_count;
+		const size_t block_cell_count = min(block_rows, vertex_count - row_begin) * vertex_count;
+
+		serialize::RoutesBlock serialize_block;
+
+		if (!serialize_block.ParseFromString(bytes)
+			|| static_cast<size_t>(serialize_block.weights_size()) != block_cell_count
+			|| static_cast<size_t>(serialize_block.prev_edges_size()) != block_cell_count) {
+			return false;
+		}
+
+		copy(serialize_block.weights().begin(), serialize_block.weights().end(), weights.begin() + cell_begin);
+		transform(serialize_block.prev_edges().begin(), serialize_block.prev_edges().end(),
+				  prev_edges.begin() + cell_begin, DecodePrevEdge);
+		return true;
+	};
+
+	const size_t block_count = vertex_count == 0 ? 0 : (vertex_count + block_rows - 1) / block_rows;
+
+	if (!ReadBlocksInParallel(input, block_count, header.block_codec(), GetMaxBlockSize(block_rows * vertex_count),
+							  section, decode_block)) {
+		return false;
+	}
+
+	routes_data = TransportRoutesData(vertex_count, move(weights), move(prev_edges));
+	return true;
+}
+
+bool ReadTransportGraph(ZeroCopyInputStream& input, const serialize::BaseHeader& header, const BaseSection& section,
+						TransportGraph& graph, vector<EdgeInfo>& edge_infos) {
+
+	const size_t edge_count = header.edge_count();
+	const size_t block_size = header.edges_block_size();
+	const size_t bus_count = header.bus_count();
+
+	if (edge_count != 0 && block_size == 0) {
+		return false;
+	}
+
+	vector<TransportEdge> edges(edge_count);
+	edge_infos.resize(edge_count);
+
+	auto decode_block = [&edges, &edge_infos, edge_count, block_size, bus_count](size_t block_index, const string& bytes) {
+
+		const size_t edge_begin = block_index * block_size;
+		const size_t block_edge_count = min(block_size, edge_count - edge_begin);
+
+		serialize::EdgesBlock serialize_block;
+
+		if (!serialize_block.ParseFromString(bytes)
+			|| static_cast<size_t>(serialize_block.vertices_from_size()) != block_edge_count
+			|| static_cast<size_t>(serialize_block.vertices_to_size()) != block_edge_count
+			|| static_cast<size_t>(serialize_block.weights_size()) != block_edge_count
+			|| static_cast<size_t>(serialize_block.bus_ids_size()) != block_edge_count
+			|| static_cast<size_t>(serialize_block.span_counts_size()) != block_edge_count) {
+			return false;
+		}
+
+		for (size_t index = 0; index < block_edge_count; ++index) {
+
+			if (serialize_block.bus_ids(index) >= bus_count) {
+				return false;
+			}
+			edges[edge_begin + index] = TransportEdge{ serialize_block.vertices_from(index), serialize_block.vertices_to(index),
+													   serialize_block.weights(index) };
+			edge_infos[edge_begin + index] = EdgeInfo{ serialize_block.bus_ids(index),
+													   static_cast<int>(serialize_block.span_counts(index)) };
+		}
+		return true;
+	};
+
+	const size_t block_count = edge_count == 0 ? 0 : (edge_count + block_size - 1) / block_size;
+
+	if (!ReadBlocksInParallel(input, block_count, header.block_codec(), GetMaxBlockSize(block_size), section,
+							  decode_block)) {
+		return false;
+	}
+
+	graph = TransportGraph(header.vertex_count(), move(edges));
+	return true;
+}
+
+bool ReadTransportHierarchy(ZeroCopyInputStream& input, const serialize::BaseHeader& header, const BaseSection& section,
+							TransportHierarchy& hierarchy) {
+
+	const size_t vertex_count = header.vertex_count();
+	const size_t shortcut_count = header.shortcut_count();
+	const size_t block_size = header.edges_block_size();
+
+	if ((vertex_count != 0 || shortcut_count != 0) && block_size == 0) {
+		return false;
+	}
+
+	hierarchy.ranks.resize(vertex_count);
+	hierarchy.shortcuts.resize(shortcut_count);
+
+	// The vertex ids and edge ids of the shortcuts are checked when the router is made
+	auto decode_block = [&hierarchy, vertex_count, shortcut_count, block_size](size_t block_index, const string& bytes) {
+
+		const size_t block_begin = block_index * block_size;
+		const size_t block_vertex_count = block_begin < vertex_count ? min(block_size, vertex_count - block_begin) : 0;
+		const size_t block_shortcut_count = block_begin < shortcut_count ? min(block_size, shortcut_count - block_begin) : 0;
+
+		serialize::HierarchyBlock serialize_block;
+
+		if (!serialize_block.ParseFromString(bytes)
+			|| static_cast<size_t>(serialize_block.vertex_ranks_size()) != block_vertex_count
+			|| static_cast<size_t>(serialize_block.vertices_from_size()) != block_shortcut_count
+			|| static_cast<size_t>(serialize_block.vertices_to_size()) != block_shortcut_count
+			|| static_cast<size_t>(serialize_block.weights_size()) != block_shortcut_count
+			|| static_cast<size_t>(serialize_block.first_edges_size()) != block_shortcut_count
+			|| static_cast<size_t>(serialize_block.second_edges_size()) != block_shortcut_count) {
+			return false;
+		}
+
+		copy(serialize_block.vertex_ranks().begin(), serialize_block.vertex_ranks().end(), hierarchy.ranks.begin() + block_begin);
+
+		for (size_t index = 0; index < block_shortcut_count; ++index) {
+			hierarchy.shortcuts[block_begin + index] = { serialize_block.vertices_from(index), serialize_block.vertices_to(index),
+														 serialize_block.weights(index), serialize_block.first_edges(index),
+														 serialize_block.second_edges(index) };
+		}
+		return true;
+	};
+
+	const size_t block_count = (max(vertex_count, shortcut_count) + max<size_t>(1, block_size) - 1) / max<size_t>(1, block_size);
+
+	return ReadBlocksInParallel(input, block_count, header.block_codec(), GetMaxBlockSize(block_size), section,
+								decode_block);
 }
\ No newline at end of file
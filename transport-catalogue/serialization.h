@@ -1,22 +1,68 @@
-#pragma once
-
-#include "transport_catalogue.h"
-#include "map_renderer.h"
-#include "transport_router.h"
-
-#include <transport_catalogue.pb.h>
-#include <filesystem>
-#include <optional>
-
-struct InputAttrs {
-	renderer::Attrs render_attrs;
-	routing::Attrs routing_attrs;
-};
-
-bool SerializeTransportCatalogue(	serialize::TransportCatalogue& serialize_transport,
-									const std::filesystem::path& serialize_result_path);
-
-bool DeserializeTransportCatalogue(std::filesystem::path& serialize_result_path,
-									transport::TransportCatalogue& transport,
-									InputAttrs& attrs, std::optional<routing::TransportRouter>& router,
-									bool is_route_request_presence);
\ No newline at end of file
+#pragma once
+
+#include "transport_catalogue.h"
+#include "map_renderer.h"
+#include "transport_router.h"
+
+#include <transport_catalogue.pb.h>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+struct InputAttrs {
+	renderer::Attrs render_attrs;
+	routing::Attrs routing_attrs;
+};
+
+// Parts of the base to load besides the stop and bus names and the bus stats,
+// which are always loaded. A batch of stat requests needs only some of them.
+struct BaseParts {
+	bool stops = true; // coordinates; a stop which is not loaded looks only referenced
+	bool bus_paths = true; // with the buses of every stop
+	bool road_distances = true;
+	bool render_settings = true;
+	bool routes = true; // routing settings, transport graph and routes table
+};
+
+enum class BaseFormat {
+	PROTOBUF,
+	MAPPED // flat arrays read in place from a mapped file, see mapped_base.h
+};
+
+// Compression of the graph and routes blocks of the protobuf base
+enum class BaseCompression {
+	NONE,
+	ZLIB
+};
+
+struct SerializationSettings {
+	std::filesystem::path file;
+	BaseFormat format = BaseFormat::PROTOBUF;
+	BaseCompression compression = BaseCompression::NONE;
+};
+
+bool SerializeTransportCatalogue(	serialize::TransportCatalogue& serialize_transport,
+									const SerializationSettings& serialization_settings);
+
+// Changes to the base requests of an existing base. Stops and buses are matched by name:
+// the given ones replace the stored ones or are added, the removed ones are dropped.
+struct BaseDelta {
+	std::filesystem::path base_file; // the base to update
+	serialize::TransportCatalogue changes; // stops and buses only
+	std::vector<std::string> removed_stops;
+	std::vector<std::string> removed_buses;
+};
+
+// Writes the base with the delta applied without building it again: the graph edges of
+// unchanged buses and the routes table rows which do not depend on the changes are kept.
+// Returns false, with the reason on std::cerr, if the delta does not fit the base.
+bool UpdateTransportCatalogue(const BaseDelta& delta, const SerializationSettings& serialization_settings);
+
+// The base format is recognized by the file contents
+bool DeserializeTransportCatalogue(std::filesystem::path& serialize_result_path,
+									transport::TransportCatalogue& transport,
+									InputAttrs& attrs, std::optional<routing::TransportRouter>& router,
+									const BaseParts& parts);
+
+void ReadRenderSettings(serialize::RenderSettings& render_settings, renderer::Attrs& render_attrs);
\ No newline at end of file
@@ -1,162 +1,333 @@
-#include "transport_catalogue.h"
-
-#include <istream>
-#include <string>
-#include <sstream>
-#include <string_view>
-#include <algorithm>
-#include <set>
-
-
-using namespace std;
-using namespace geo;
-
-namespace transport {
-
-void TransportCatalogue::AddStop(string&& stop_name, StopData&& stop) {
-	
-	if (auto word_it = stop_names_.find(stop_name); word_it != stop_names_.end()) {
-		stops_[*word_it] = move(stop);
-	}
-	else {
-		stops_[*stop_names_.insert(move(stop_name)).first] = move(stop);
-	}
-}
-
-void TransportCatalogue::AddBus(string&& bus_name, list<string>&& moving_bus_path, bool path_is_ring) {
-
-	BusData& bus = buses_[move(bus_name)];
-	bus.SetStateRingOfPath(path_is_ring);
-	for (string& stop_name : moving_bus_path) {
-		if (auto word_it = stop_names_.find(stop_name); word_it != stop_names_.end()) {
-			bus.GetPath().push_back(*word_it);
-			stop_names_in_buses_path_.insert(*word_it);
-		}
-		else {
-			const string& stop_name_in_path = *stop_names_.insert(move(stop_name)).first;
-			bus.GetPath().push_back(stop_name_in_path);
-			stop_names_in_buses_path_.insert(stop_name_in_path);
-		}
-	}
-}
-
-pair<StopData, bool> TransportCatalogue::GetStopData(const string_view stop_name) const {
-	auto stop_it = stops_.find(stop_name);
-	if (stop_it == stops_.end()) {
-		return { StopData{Coordinates {}}, false };
-	}
-	else {
-		return { stop_it->second, true };
-	}
-}
-
-pair<const BusData&, bool> TransportCatalogue::GetBusData(const string_view bus_name) const {
-	auto bus_it = buses_.find(string(bus_name));
-	if (bus_it == buses_.end()) {
-		static BusData path;
-		return { path, false };
-	}
-	else {
-		return { bus_it->second, true };
-	}
-}
-
-set<string_view> TransportCatalogue::GetBusList(const std::string_view stop_name) const {
-	set<string_view> buses_with_stop;
-
-	if (!GetStopData(stop_name).second) {
-		throw invalid_argument("Stop not found"s);
-	}
-	for (const auto& [bus_name, bus] : buses_) {
-		auto bus_it = find(bus.GetPath().begin(), bus.GetPath().end(), stop_name);
-		if (bus_it != bus.GetPath().end()) {
-			buses_with_stop.insert(bus_name);
-		}
-	}
-	return buses_with_stop;
-}
-
-std::unordered_set<std::string>& TransportCatalogue::GetStopNames() {
-	return stop_names_;
-}
-
-const std::unordered_set<std::string>& TransportCatalogue::GetStopNames() const {
-	return stop_names_;
-}
-
-std::vector<geo::Coordinates> TransportCatalogue::GetAllStopCoordinatesInBusPathes() const {
-	vector<Coordinates> coordinates;
-	for (auto& stop_name : stop_names_in_buses_path_) {
-		coordinates.push_back(stops_.at(stop_name).GetCoordinates());
-	}
-	return coordinates;
-}
-
-std::set<std::string_view> TransportCatalogue::GetBusNames() const {
-	set<string_view> bus_names;
-
-	for (auto& [bus_name, _] : buses_) {
-		bus_names.insert(bus_name);
-	}
-	return bus_names;
-}
-
-size_t TransportCatalogue::GetStopsCount() const {
-	return stop_names_.size();
-}
-
-const std::unordered_map<std::string, BusData>& TransportCatalogue::GetBuses() const {
-	return buses_;
-}
-
-size_t TransportCatalogue::GetDistance(std::string_view stop_from, std::string_view stop_to) const {
-	auto stop_distances = GetStopData(stop_from).first.GetDistances();
-
-	size_t distance = 0;
-
-	if (auto distance_it = stop_distances.find(stop_to); distance_it != stop_distances.end()) {
-		distance = distance_it->second;
-	}
-	else {
-		distance = GetStopData(stop_to).first.GetDistances().at(stop_from);
-	}
-	return distance;
-}
-
-bool BusData::IsRing() const {
-	return is_ring_;
-}
-
-const std::list<std::string_view>& BusData::GetPath() const {
-	return path_;
-}
-
-std::list<std::string_view>& BusData::GetPath() {
-	return path_;
-}
-
-void BusData::SetStateRingOfPath(bool is_ring) {
-	is_ring_ = is_ring;
-}
-
-StopData::StopData(const Coordinates& coordinates) : coordinates_(coordinates) {}
-
-StopData::StopData(const Coordinates& coordinates,
-	Distances&& distance_to_stop) : coordinates_(coordinates),
-	distance_to_stop_(move(distance_to_stop)) {}
-
-const Coordinates& StopData::GetCoordinates() const {
-	return coordinates_;
-}
-
-Coordinates& StopData::GetCoordinates() {
-	return coordinates_;
-}
-
-const StopData::Distances& StopData::GetDistances() const {
-	return distance_to_stop_;
-}
-
-
-
-} // namespace transport
\ No newline at end of file
+#include "transport_catalogue.h"
+
+#include <istream>
+#include <string>
+#include <sstream>
+#include <string_view>
+#include <algorithm>
+#include <limits>
+#include <set>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+using namespace geo;
+
+namespace transport {
+
+StopId TransportCatalogue::AddStopName(string_view stop_name) {
+
+	if (auto id_it = stop_ids_.find(stop_name); id_it != stop_ids_.end()) {
+		return id_it->second;
+	}
+	const StopId stop_id = static_cast<StopId>(stop_names_.size());
+	stop_ids_.emplace(stop_names_.emplace_back(stop_name), stop_id);
+	stops_.emplace_back();
+	stop_to_buses_.emplace_back();
+	return stop_id;
+}
+
+void TransportCatalogue::AddStop(string_view stop_name, StopData&& stop) {
+	stops_[AddStopName(stop_name)] = move(stop);
+}
+
+void TransportCatalogue::AddStop(StopId stop_id, StopData&& stop) {
+	stops_.at(stop_id) = move(stop);
+}
+
+BusId TransportCatalogue::AddBus(string&& bus_name, vector<StopId>&& bus_path, bool path_is_ring) {
+
+	BusId bus_id;
+	if (auto id_it = bus_ids_.find(bus_name); id_it != bus_ids_.end()) {
+		bus_id = id_it->second;
+	}
+	else {
+		bus_id = static_cast<BusId>(bus_names_.size());
+		bus_ids_.emplace(bus_names_.emplace_back(move(bus_name)), bus_id);
+		buses_.emplace_back();
+	}
+
+	BusData& bus = buses_[bus_id];
+	bus.SetStateRingOfPath(path_is_ring);
+	const string_view bus_name_view = bus_names_[bus_id];
+
+	// A bus given again continues its path; move the old part to the arena end to keep it contiguous
+	if (bus.path_size_ != 0 && bus.path_offset_ + bus.path_size_ != paths_.size()) {
+		const size_t old_offset = bus.path_offset_;
+		bus.path_offset_ = static_cast<uint32_t>(paths_.size());
+		for (size_t index = 0; index < bus.path_size_; ++index) {
+			paths_.push_back(paths_[old_offset + index]);
+		}
+	}
+	else if (bus.path_size_ == 0) {
+		bus.path_offset_ = static_cast<uint32_t>(paths_.size());
+	}
+	paths_.insert(paths_.end(), bus_path.begin(), bus_path.end());
+	bus.path_size_ += static_cast<uint32_t>(bus_path.size());
+
+	for (StopId stop_id : bus_path) {
+
+		vector<BusId>& buses_with_stop = stop_to_buses_.at(stop_id);
+		auto insert_it = lower_bound(buses_with_stop.begin(), buses_with_stop.end(), bus_name_view,
+									 [this](BusId lhs, string_view rhs) { return bus_names_[lhs] < rhs; });
+		if (insert_it == buses_with_stop.end() || *insert_it != bus_id) {
+			buses_with_stop.insert(insert_it, bus_id);
+		}
+	}
+	return bus_id;
+}
+
+optional<StopId> TransportCatalogue::FindStopId(string_view stop_name) const {
+	if (auto id_it = stop_ids_.find(stop_name); id_it != stop_ids_.end()) {
+		return id_it->second;
+	}
+	return nullopt;
+}
+
+optional<BusId> TransportCatalogue::FindBusId(string_view bus_name) const {
+	if (auto id_it = bus_ids_.find(bus_name); id_it != bus_ids_.end()) {
+		return id_it->second;
+	}
+	return nullopt;
+}
+
+string_view TransportCatalogue::GetStopName(StopId stop_id) const {
+	return stop_names_[stop_id];
+}
+
+string_view TransportCatalogue::GetBusName(BusId bus_id) const {
+	return bus_names_[bus_id];
+}
+
+const StopData* TransportCatalogue::FindStop(string_view stop_name) const {
+	optional<StopId> stop_id = FindStopId(stop_name);
+	return stop_id ? GetStopData(*stop_id) : nullptr;
+}
+
+const BusData* TransportCatalogue::FindBus(string_view bus_name) const {
+	optional<BusId> bus_id = FindBusId(bus_name);
+	return bus_id ? &buses_[*bus_id] : nullptr;
+}
+
+const StopData* TransportCatalogue::GetStopData(StopId stop_id) const {
+	const optional<StopData>& stop = stops_[stop_id];
+	return stop ? &*stop : nullptr;
+}
+
+const BusData& TransportCatalogue::GetBusData(BusId bus_id) const {
+	return buses_[bus_id];
+}
+
+PathView TransportCatalogue::GetBusPath(BusId bus_id) const {
+	const BusData& bus = buses_[bus_id];
+	const StopId* path_begin = paths_.data() + bus.path_offset_;
+	return PathView{ path_begin, path_begin + bus.path_size_ };
+}
+
+template<typename ITERATOR>
+size_t TransportCatalogue::CalculateRoadLengthOneWay(ITERATOR begin_it, ITERATOR end_it) const {
+	size_t road_length = 0;
+
+	for (auto stop_it = begin_it; next(stop_it) != end_it; ++stop_it) {
+		road_length += GetDistance(*stop_it, *next(stop_it));
+	}
+	return road_length;
+}
+
+BusStats TransportCatalogue::ComputeBusStats(BusId bus_id) const {
+	const BusData& bus = buses_[bus_id];
+	const PathView path = GetBusPath(bus_id);
+	BusStats stats;
+
+	if (path.empty()) {
+		return stats;
+	}
+
+	stats.stop_count = bus.IsRing() ? path.size() : path.size() * 2 - 1;
+	stats.unique_stop_count = unordered_set<StopId>(path.begin(), path.end()).size();
+
+	for (auto stop_it = path.begin(); next(stop_it) != path.end(); ++stop_it) {
+		stats.geo_length += ComputeDistance(GetStopCoordinates(*stop_it), GetStopCoordinates(*next(stop_it)));
+	}
+	stats.route_length = CalculateRoadLengthOneWay(path.begin(), path.end());
+
+	if (!bus.IsRing()) {
+		stats.geo_length *= 2;
+		stats.route_length += CalculateRoadLengthOneWay(path.rbegin(), path.rend());
+	}
+	return stats;
+}
+
+void TransportCatalogue::SetBusStats(BusId bus_id, const BusStats& stats) {
+	buses_[bus_id].stats_ = stats;
+}
+
+const Coordinates& TransportCatalogue::GetStopCoordinates(StopId stop_id) const {
+	return stops_[stop_id].value().GetCoordinates();
+}
+
+const vector<BusId>& TransportCatalogue::GetBusList(StopId stop_id) const {
+	return stop_to_buses_[stop_id];
+}
+
+std::vector<geo::Coordinates> TransportCatalogue::GetAllStopCoordinatesInBusPathes() const {
+	vector<Coordinates> coordinates;
+	for (StopId stop_id = 0; stop_id < stops_.size(); ++stop_id) {
+		if (!stop_to_buses_[stop_id].empty()) {
+			coordinates.push_back(GetStopCoordinates(stop_id));
+		}
+	}
+	return coordinates;
+}
+
+std::vector<BusId> TransportCatalogue::GetBusIdsSortedByName() const {
+	vector<BusId> bus_ids(buses_.size());
+	for (BusId bus_id = 0; bus_id < bus_ids.size(); ++bus_id) {
+		bus_ids[bus_id] = bus_id;
+	}
+	sort(bus_ids.begin(), bus_ids.end(), [this](BusId lhs, BusId rhs) { return bus_names_[lhs] < bus_names_[rhs]; });
+	return bus_ids;
+}
+
+size_t TransportCatalogue::GetStopsCount() const {
+	return stop_names_.size();
+}
+
+size_t TransportCatalogue::GetBusesCount() const {
+	return bus_names_.size();
+}
+
+void TransportCatalogue::SetDistance(StopId stop_from, StopId stop_to, size_t distance) {
+	distances_.Set(stop_from, stop_to, distance);
+}
+
+size_t TransportCatalogue::GetDistance(StopId stop_from, StopId stop_to) const {
+	if (optional<size_t> distance = distances_.Find(stop_from, stop_to)) {
+		return *distance;
+	}
+	throw out_of_range("No road distance between "s + string(GetStopName(stop_from)) + " and "s
+					   + string(GetStopName(stop_to)));
+}
+
+const RoadDistances& TransportCatalogue::GetDistances() const {
+	return distances_;
+}
+
+bool BusData::IsRing() const {
+	return is_ring_;
+}
+
+void BusData::SetStateRingOfPath(bool is_ring) {
+	is_ring_ = is_ring;
+}
+
+const BusStats& BusData::GetStats() const {
+	return stats_;
+}
+
+PathView::PathView(Iterator begin, Iterator end) : begin_(begin), end_(end) {}
+
+PathView::Iterator PathView::begin() const {
+	return begin_;
+}
+
+PathView::Iterator PathView::end() const {
+	return end_;
+}
+
+PathView::ReverseIterator PathView::rbegin() const {
+	return ReverseIterator{ end_ };
+}
+
+PathView::ReverseIterator PathView::rend() const {
+	return ReverseIterator{ begin_ };
+}
+
+size_t PathView::size() const {
+	return static_cast<size_t>(end_ - begin_);
+}
+
+bool PathView::empty() const {
+	return begin_ == end_;
+}
+
+StopId PathView::front() const {
+	return *begin_;
+}
+
+StopId PathView::back() const {
+	return *prev(end_);
+}
+
+StopData::StopData(const Coordinates& coordinates) : coordinates_(coordinates) {}
+
+const Coordinates& StopData::GetCoordinates() const {
+	return coordinates_;
+}
+
+Coordinates& StopData::GetCoordinates() {
+	return coordinates_;
+}
+
+void RoadDistances::Set(StopId stop_from, StopId stop_to, size_t distance) {
+	if (distance > numeric_limits<uint32_t>::max()) {
+		throw out_of_range("Road distance does not fit in 32 bits"s);
+	}
+	if ((size_ + 2) * 2 > slots_.size()) {
+		Rehash(max<size_t>(16, slots_.size() * 2));
+	}
+	Insert(MakeKey(stop_from, stop_to), static_cast<uint32_t>(distance), true);
+	Insert(MakeKey(stop_to, stop_from), static_cast<uint32_t>(distance), false);
+}
+
+optional<size_t> RoadDistances::Find(StopId stop_from, StopId stop_to) const {
+	if (slots_.empty()) {
+		return nullopt;
+	}
+	const Slot& slot = slots_[FindSlot(MakeKey(stop_from, stop_to))];
+	if (slot.key == EMPTY_KEY) {
+		return nullopt;
+	}
+	return slot.distance;
+}
+
+size_t RoadDistances::GetSize() const {
+	return size_;
+}
+
+uint64_t RoadDistances::MakeKey(StopId stop_from, StopId stop_to) {
+	return (uint64_t{ stop_from } << 32) | stop_to;
+}
+
+// Linear probing from a Fibonacci hash of the key; the table is never more than half full
+size_t RoadDistances::FindSlot(uint64_t key) const {
+	const size_t mask = slots_.size() - 1;
+	for (size_t index = (key * 0x9E3779B97F4A7C15ull) >> 32 & mask; ; index = (index + 1) & mask) {
+		if (slots_[index].key == key || slots_[index].key == EMPTY_KEY) {
+			return index;
+		}
+	}
+}
+
+void RoadDistances::Insert(uint64_t key, uint32_t distance, bool is_explicit) {
+	Slot& slot = slots_[FindSlot(key)];
+	if (slot.key == EMPTY_KEY) {
+		slot = Slot{ key, distance, is_explicit };
+		++size_;
+	}
+	else if (is_explicit || !slot.is_explicit) {
+		slot.distance = distance;
+		slot.is_explicit = is_explicit;
+	}
+}
+
+void RoadDistances::Rehash(size_t capacity) {
+	vector<Slot> old_slots = exchange(slots_, vector<Slot>(capacity));
+	for (const Slot& slot : old_slots) {
+		if (slot.key != EMPTY_KEY) {
+			slots_[FindSlot(slot.key)] = slot;
+		}
+	}
+}
+
+} // namespace transport
@@ -1,76 +1,181 @@
-#pragma once
-
-#include "geo.h"
-
-#include <string_view>
-#include <istream>
-#include <unordered_map>
-#include <unordered_set>
-#include <list>
-#include <string>
-#include <set>
-#include <vector>
-
-namespace transport {
-
-class BusData {
-public:
-	bool IsRing() const;
-
-	const std::list<std::string_view>& GetPath() const;
-	std::list<std::string_view>& GetPath();
-
-	void SetStateRingOfPath(bool is_ring);
-
-private:
-	bool is_ring_;
-	std::list<std::string_view> path_;
-};
-
-class StopData {
-	using Distances = std::unordered_map<std::string_view, size_t>; // size_t - meters
-
-public:
-	StopData() = default;
-	explicit StopData(const geo::Coordinates& coordinates);
-	StopData(const geo::Coordinates& coordinates, Distances&& distance_to_stop);
-
-	const geo::Coordinates& GetCoordinates() const;
-	geo::Coordinates& GetCoordinates();
-	const Distances& GetDistances() const;
-
-private:
-	geo::Coordinates coordinates_;
-	Distances distance_to_stop_;
-};
-
-class TransportCatalogue {
-public:
-	void AddStop(std::string&& stop_name, StopData&& stop);
-	void AddBus(std::string&& bus_name, std::list<std::string>&& bus_path, bool path_is_ring);
-
-	std::pair<StopData, bool> GetStopData(const std::string_view stop_name) const;
-	std::pair<const BusData&, bool> GetBusData(const std::string_view bus_name) const;
-	std::set<std::string_view> GetBusList(const std::string_view stop_name) const;
-
-	std::unordered_set<std::string>& GetStopNames();
-	const std::unordered_set<std::string>& GetStopNames() const;
-	std::vector<geo::Coordinates> GetAllStopCoordinatesInBusPathes() const;
-	std::set<std::string_view> GetBusNames() const;
-
-	size_t GetStopsCount() const;
-
-	///
-	size_t GetDistance(std::string_view stop_from, std::string_view stop_to) const;
-	const std::unordered_map<std::string, BusData>& GetBuses() const;
-
-
-private:
-	std::unordered_set<std::string> stop_names_;
-	std::unordered_map<std::string_view, StopData> stops_;
-	std::unordered_map<std::string, BusData> buses_;
-	std::unordered_set<std::string_view> stop_names_in_buses_path_;
-};
-
-} // namespace transport
-
+#pragma once
+
+#include "geo.h"
+
+#include <cstdint>
+#include <deque>
+#include <string_view>
+#include <istream>
+#include <iterator>
+#include <unordered_map>
+#include <unordered_set>
+#include <optional>
+#include <string>
+#include <set>
+#include <vector>
+
+namespace transport {
+
+// Dense handles assigned in the order names are first seen while loading
+using StopId = uint32_t;
+using BusId = uint32_t;
+
+// Read-only view of a bus path stored in the catalogue path arena
+class PathView {
+public:
+	using Iterator = const StopId*;
+	using ReverseIterator = std::reverse_iterator<Iterator>;
+
+	PathView(Iterator begin, Iterator end);
+
+	Iterator begin() const;
+	Iterator end() const;
+	ReverseIterator rbegin() const;
+	ReverseIterator rend() const;
+
+	size_t size() const;
+	bool empty() const;
+	StopId front() const;
+	StopId back() const;
+
+private:
+	Iterator begin_;
+	Iterator end_;
+};
+
+// Answer to a Bus request; computed once by make_base and stored in the base
+struct BusStats {
+	size_t stop_count = 0;
+	size_t unique_stop_count = 0;
+	size_t route_length = 0; // meters by road
+	double geo_length = 0.; // meters along the great circle
+};
+
+class BusData {
+public:
+	bool IsRing() const;
+	void SetStateRingOfPath(bool is_ring);
+
+	const BusStats& GetStats() const;
+
+private:
+	friend class TransportCatalogue;
+
+	bool is_ring_ = false;
+	BusStats stats_;
+	uint32_t path_offset_ = 0; // first stop of the path in the path arena
+	uint32_t path_size_ = 0;
+};
+
+class StopData {
+public:
+	StopData() = default;
+	explicit StopData(const geo::Coordinates& coordinates);
+
+	const geo::Coordinates& GetCoordinates() const;
+	geo::Coordinates& GetCoordinates();
+
+private:
+	geo::Coordinates coordinates_;
+};
+
+// Road distances of the whole catalogue in one open-addressing hash table keyed by
+// the (from, to) stop pair. Setting from -> to also fills to -> from unless that
+// direction is given explicitly, so either direction is found with a single probe.
+class RoadDistances {
+public:
+	// Distances are stored in 32 bits; a larger one throws std::out_of_range
+	void Set(StopId stop_from, StopId stop_to, size_t distance);
+
+	std::optional<size_t> Find(StopId stop_from, StopId stop_to) const;
+
+	// Explicitly set distances only, in table order
+	template <typename Function>
+	void ForEachExplicit(Function function) const;
+
+	size_t GetSize() const;
+
+private:
+	struct Slot {
+		uint64_t key = EMPTY_KEY;
+		uint32_t distance = 0; // meters
+		bool is_explicit = false;
+	};
+
+	static constexpr uint64_t EMPTY_KEY = UINT64_MAX;
+
+	static uint64_t MakeKey(StopId stop_from, StopId stop_to);
+	size_t FindSlot(uint64_t key) const;
+	void Insert(uint64_t key, uint32_t distance, bool is_explicit);
+	void Rehash(size_t capacity);
+
+	std::vector<Slot> slots_;
+	size_t size_ = 0;
+};
+
+template <typename Function>
+void RoadDistances::ForEachExplicit(Function function) const {
+	for (const Slot& slot : slots_) {
+		if (slot.key != EMPTY_KEY && slot.is_explicit) {
+			function(static_cast<StopId>(slot.key >> 32), static_cast<StopId>(slot.key), size_t{ slot.distance });
+		}
+	}
+}
+
+class TransportCatalogue {
+public:
+	StopId AddStopName(std::string_view stop_name);
+	void AddStop(std::string_view stop_name, StopData&& stop);
+	void AddStop(StopId stop_id, StopData&& stop);
+	BusId AddBus(std::string&& bus_name, std::vector<StopId>&& bus_path, bool path_is_ring);
+
+	std::optional<StopId> FindStopId(std::string_view stop_name) const;
+	std::optional<BusId> FindBusId(std::string_view bus_name) const;
+	std::string_view GetStopName(StopId stop_id) const;
+	std::string_view GetBusName(BusId bus_id) const;
+
+	// nullptr if the stop (bus) is unknown; nothing is copied
+	const StopData* FindStop(std::string_view stop_name) const;
+	const BusData* FindBus(std::string_view bus_name) const;
+
+	// nullptr if the stop name is only referenced by other stops or buses
+	const StopData* GetStopData(StopId stop_id) const;
+	const BusData& GetBusData(BusId bus_id) const;
+	PathView GetBusPath(BusId bus_id) const;
+
+	BusStats ComputeBusStats(BusId bus_id) const;
+	void SetBusStats(BusId bus_id, const BusStats& stats);
+	const geo::Coordinates& GetStopCoordinates(StopId stop_id) const;
+
+	// Buses passing through the stop, sorted by name
+	const std::vector<BusId>& GetBusList(StopId stop_id) const;
+
+	std::vector<geo::Coordinates> GetAllStopCoordinatesInBusPathes() const;
+	std::vector<BusId> GetBusIdsSortedByName() const;
+
+	size_t GetStopsCount() const;
+	size_t GetBusesCount() const;
+
+	void SetDistance(StopId stop_from, StopId stop_to, size_t distance);
+	size_t GetDistance(StopId stop_from, StopId stop_to) const;
+	const RoadDistances& GetDistances() const;
+
+private:
+	template<typename ITERATOR>
+	size_t CalculateRoadLengthOneWay(ITERATOR begin_it, ITERATOR end_it) const;
+
+	std::deque<std::string> stop_names_;
+	std::unordered_map<std::string_view, StopId> stop_ids_;
+	std::vector<std::optional<StopData>> stops_; // nullopt - the name is only referenced
+
+	std::deque<std::string> bus_names_;
+	std::unordered_map<std::string_view, BusId> bus_ids_;
+	std::vector<BusData> buses_;
+	std::vector<StopId> paths_; // all bus paths one after another
+
+	std::vector<std::vector<BusId>> stop_to_buses_; // bus ids sorted by bus name
+
+	RoadDistances distances_;
+};
+
+} // namespace transport
@@ -1,104 +1,453 @@
-#include "transport_router.h"
-#include "transport_catalogue.h"
-#include "algorithm"
-
-
-namespace routing {
-
-using namespace std;
-using namespace transport;
-
-TransportRouter::TransportRouter(const TransportCatalogue& transport_catalogue, Attrs attrs)
-								:
-								transport_catalogue_(transport_catalogue),
-								attrs_(attrs),
-								graph_(transport_catalogue.GetStopNames().size())
-
-{
-	RouterInit();
-	router_.emplace(graph_);
-}
-
-TransportRouter::TransportRouter(const TransportCatalogue& transport_catalogue, Attrs attrs, TransportRoutesData&& routes_data)
-	:
-	transport_catalogue_(transport_catalogue),
-	attrs_(attrs),
-	graph_(transport_catalogue.GetStopNames().size())
-
-{
-	RouterInit();
-	router_.emplace(graph_, move(routes_data));
-}
-
-void TransportRouter::RouterInit() {
-
-	vertex_id_to_stop_name_.reserve(transport_catalogue_.GetStopNames().size());
-	MatchStopsWithVertexId();
-
-	const std::unordered_map<std::string, BusData>& buses = transport_catalogue_.GetBuses();
-
-	for (auto& [bus_name, bus] : buses) {
-
-		AddBusEdgesOneWay(bus_name, bus.GetPath().begin(), bus.GetPath().end());
-
-		if (!bus.IsRing()) {
-			AddBusEdgesOneWay(bus_name, bus.GetPath().rbegin(), bus.GetPath().rend());
-		}
-	}
-}
-
-void TransportRouter::AddEdge(const TransportEdge& edge, const EdgeInfo& edge_info) {
-	graph_.AddEdge(edge);
-	edge_id_to_info_.push_back(edge_info);
-}
-
-RouteInfo TransportRouter::BuildRoute(size_t vertex_id_from, size_t vertex_id_to) const {
-	return router_->BuildRoute(vertex_id_from, vertex_id_to);
-}
-
-void TransportRouter::MatchStopsWithVertexId() {
-	size_t count = 0;
-
-	const std::unordered_set<std::string>& stops = transport_catalogue_.GetStopNames();
-
-	for_each(stops.begin(), stops.end(), 
-			 [&count, this](string_view stop) {
-												stops_to_vertex_id_[stop] = count++; 
-												vertex_id_to_stop_name_.push_back(stop);
-											  }
-			);
-}
-
-VertexId TransportRouter::GetVertexId(string_view stop_name) const {
-	return stops_to_vertex_id_.at(stop_name);
-}
-
-VertexId TransportRouter::GetEdgeVertexFrom(graph::EdgeId edge_id) const {
-	return graph_.GetEdge(edge_id).from;
-}
-
-std::string_view TransportRouter::GetVertexStopName(graph::EdgeId edge_id) const {
-	return vertex_id_to_stop_name_[edge_id];
-}
-
-double TransportRouter::GetEdgeWeight(graph::EdgeId edge_id) const {
-	return graph_.GetEdge(edge_id).weight;
-}
-
-const EdgeInfo& TransportRouter::GetEdgeInfo(graph::EdgeId edge_id) const {
-	return edge_id_to_info_.at(edge_id);
-}
-
-size_t TransportRouter::GetWaitTime() const {
-	return attrs_.bus_wait_time;
-}
-
-const TransportGraph& TransportRouter::GetGraph() const {
-	return graph_;
-}
-
-const graph::Router<double>& TransportRouter::GetRouter() const {
-	return *router_;
-}
-
+#include "transport_router.h"
+#include "transport_catalogue.h"
+#include "algorithm"
+
+
+namespace routing {
+
+using namespace std;
+using namespace transport;
+
+namespace {
+
+size_t CountGraphVertices(const TransportCatalogue& transport_catalogue, const Attrs& attrs) {
+
+	size_t vertex_count = transport_catalogue.GetStopsCount();
+
+	if (attrs.graph_model == GraphModel::STOP_BUS) {
+		for (BusId bus_id = 0; bus_id < transport_catalogue.GetBusesCount(); ++bus_id) {
+			const size_t path_size = transport_catalogue.GetBusPath(bus_id).size();
+			vertex_count += transport_catalogue.GetBusData(bus_id).IsRing() ? path_size : 2 * path_size;
+		}
+	}
+	return vertex_count;
+}
+
+} // namespace
+
+TransportRouter::TransportRouter(const TransportCatalogue& transport_catalogue, Attrs attrs)
+								:
+								transport_catalogue_(transport_catalogue),
+								attrs_(attrs),
+								graph_(CountGraphVertices(transport_catalogue, attrs))
+
+{
+	RouterInit();
+	SearchInit(nullopt, nullopt);
+}
+
+TransportRouter::TransportRouter(const TransportCatalogue& transport_catalogue, Attrs attrs, TransportGraph&& graph,
+								 vector<EdgeInfo>&& edge_infos, optional<TransportRoutesData>&& routes_data,
+								 optional<TransportHierarchy>&& hierarchy)
+	:
+	transport_catalogue_(transport_catalogue),
+	attrs_(attrs),
+	graph_(move(graph)),
+	edge_id_to_info_(move(edge_infos))
+
+{
+	// Bus paths are not loaded for routing alone, so the ride vertices of the stop-bus graph are not counted
+	const size_t stop_count = transport_catalogue.GetStopsCount();
+	const bool is_vertex_count_valid = attrs_.graph_model == GraphModel::STOP_BUS ? graph_.GetVertexCount() >= stop_count
+																				  : graph_.GetVertexCount() == stop_count;
+
+	if (!is_vertex_count_valid || edge_id_to_info_.size() != graph_.GetEdgeCount()) {
+		throw invalid_argument("Transport graph does not match the catalogue");
+	}
+	SearchInit(move(routes_data), move(hierarchy));
+}
+
+void TransportRouter::RouterInit() {
+
+	VertexId ride_vertex = transport_catalogue_.GetStopsCount();
+
+	for (BusId bus_id = 0; bus_id < transport_catalogue_.GetBusesCount(); ++bus_id) {
+
+		const PathView path = transport_catalogue_.GetBusPath(bus_id);
+		const bool is_ring = transport_catalogue_.GetBusData(bus_id).IsRing();
+
+		if (attrs_.graph_model == GraphModel::STOP_BUS) {
+			AddBusRideEdgesOneWay(bus_id, path.begin(), path.end(), ride_vertex);
+
+			if (!is_ring) {
+				AddBusRideEdgesOneWay(bus_id, path.rbegin(), path.rend(), ride_vertex);
+			}
+			continue;
+		}
+		AddBusEdgesOneWay(bus_id, path.begin(), path.end());
+
+		if (!is_ring) {
+			AddBusEdgesOneWay(bus_id, path.rbegin(), path.rend());
+		}
+	}
+}
+
+void TransportRouter::SearchInit(optional<TransportRoutesData>&& routes_data, optional<TransportHierarchy>&& hierarchy) {
+
+	if (routes_data) {
+		if (routes_data->GetVertexCount() != graph_.GetVertexCount()) {
+			throw invalid_argument("Routes table does not match the transport graph");
+		}
+		router_.emplace(graph_, move(*routes_data));
+	}
+	else if (hierarchy) {
+		contraction_router_.emplace(graph_, move(*hierarchy));
+	}
+	else if (attrs_.router_mode == RouterMode::ON_DEMAND) {
+		dijkstra_router_.emplace(graph_);
+	}
+	else if (attrs_.router_mode == RouterMode::CONTRACTED) {
+		contraction_router_.emplace(graph_);
+	}
+	else {
+		router_.emplace(graph_);
+	}
+}
+
+void TransportRouter::AddEdge(const TransportEdge& edge, const EdgeInfo& edge_info) {
+	graph_.AddEdge(edge);
+	edge_id_to_info_.push_back(edge_info);
+}
+
+RouteInfo TransportRouter::BuildRoute(size_t vertex_id_from, size_t vertex_id_to) const {
+	if (dijkstra_router_ && route_cache_) {
+		return dijkstra_router_->BuildRoute(*GetRouteTree(vertex_id_from), vertex_id_to);
+	}
+	if (dijkstra_router_) {
+		return dijkstra_router_->BuildRoute(vertex_id_from, vertex_id_to);
+	}
+	if (contraction_router_) {
+		return contraction_router_->BuildRoute(vertex_id_from, vertex_id_to);
+	}
+	return router_->BuildRoute(vertex_id_from, vertex_id_to);
+}
+
+vector<vector<RouteInfo>> TransportRouter::BuildRouteMatrix(const vector<VertexId>& from, const vector<VertexId>& to,
+															 bool with_edges) const {
+	if (contraction_router_) {
+		return contraction_router_->BuildRoutes(from, to, with_edges);
+	}
+	vector<vector<RouteInfo>> routes;
+	routes.reserve(from.size());
+	for (const VertexId vertex_id_from : from) {
+		if (dijkstra_router_ && !route_cache_) {
+			routes.push_back(dijkstra_router_->BuildRoutes(vertex_id_from, to));
+			continue;
+		}
+		vector<RouteInfo>& row = routes.emplace_back();
+		row.reserve(to.size());
+		if (dijkstra_router_) {
+			const shared_ptr<const RouteTreeCache::Tree> tree = GetRouteTree(vertex_id_from);
+			for (const VertexId vertex_id_to : to) {
+				row.push_back(dijkstra_router_->BuildRoute(*tree, vertex_id_to));
+			}
+			continue;
+		}
+		for (const VertexId vertex_id_to : to) {
+			row.push_back(router_->BuildRoute(vertex_id_from, vertex_id_to));
+		}
+	}
+	return routes;
+}
+
+shared_ptr<const RouteTreeCache::Tree> TransportRouter::GetRouteTree(VertexId vertex_id_from) const {
+	shared_ptr<const RouteTreeCache::Tree> tree = route_cache_->Find(vertex_id_from);
+	if (!tree) {
+		tree = make_shared<const RouteTreeCache::Tree>(dijkstra_router_->BuildTree(vertex_id_from));
+		route_cache_->Insert(tree);
+	}
+	return tree;
+}
+
+// A route leaves a stop vertex only by boarding a bus; in the span model the boarding edge
+// also holds the ride, in the stop-bus model the ride and alighting edges which follow it do
+vector<RouteLeg> TransportRouter::GetRouteLegs(const vector<graph::EdgeId>& edges) const {
+
+	vector<RouteLeg> legs;
+
+	for (const graph::EdgeId edge_id : edges) {
+
+		const TransportEdge& edge = graph_.GetEdge(edge_id);
+		const EdgeInfo& edge_info = GetEdgeInfo(edge_id);
+
+		if (edge.from < transport_catalogue_.GetStopsCount()) {
+			legs.push_back(RouteLeg{ GetVertexStop(edge.from), edge_info.bus_id,
+									 edge.weight - static_cast<double>(attrs_.bus_wait_time), edge_info.span_count });
+		}
+		else {
+			legs.back().ride_time += edge.weight;
+			legs.back().span_count += edge_info.span_count;
+		}
+	}
+	return legs;
+}
+
+VertexId TransportRouter::GetVertexId(StopId stop_id) const {
+	return stop_id;
+}
+
+VertexId TransportRouter::GetEdgeVertexFrom(graph::EdgeId edge_id) const {
+	return graph_.GetEdge(edge_id).from;
+}
+
+StopId TransportRouter::GetVertexStop(VertexId vertex_id) const {
+	return static_cast<StopId>(vertex_id);
+}
+
+double TransportRouter::GetEdgeWeight(graph::EdgeId edge_id) const {
+	return graph_.GetEdge(edge_id).weight;
+}
+
+const EdgeInfo& TransportRouter::GetEdgeInfo(graph::EdgeId edge_id) const {
+	return edge_id_to_info_.at(edge_id);
+}
+
+double TransportRouter::GetTravelTime(StopId stop_from, StopId stop_to) const {
+	const size_t distance = transport_catalogue_.GetDistance(stop_from, stop_to);
+	return (distance / (attrs_.bus_velocity / 3.6)) / 60;
+}
+
+size_t TransportRouter::GetWaitTime() const {
+	return attrs_.bus_wait_time;
+}
+
+const TransportGraph& TransportRouter::GetGraph() const {
+	return graph_;
+}
+
+const graph::Router<double>& TransportRouter::GetRouter() const {
+	return *router_;
+}
+
+const graph::ContractionRouter<double>& TransportRouter::GetContractionRouter() const {
+	return *contraction_router_;
+}
+
+void TransportRouter::EnableRouteCache(size_t memory_limit) {
+	if (dijkstra_router_) {
+		route_cache_ = make_unique<RouteTreeCache>(memory_limit);
+	}
+}
+
+optional<RouteCacheStats> TransportRouter::GetRouteCacheStats() const {
+	if (!route_cache_) {
+		return nullopt;
+	}
+	return route_cache_->GetStats();
+}
+
+// Cells of a kept row whose route lost an edge are searched again from the cells which
+// kept theirs: with edges only removed, the kept routes are still the shortest ones. The
+// added edges are left out, as they are inserted into every row afterwards, and a route
+// through one of them found here would not reach the kept cells beyond it.
+void RepairRoutesRow(const TransportGraph& graph, const graph::FrozenWeightedGraph<double>& frozen_graph,
+					 const vector<vector<graph::EdgeId>>& incoming_edges, const vector<bool>& is_added_edge,
+					 VertexId vertex_from, const vector<VertexId>& lost_vertices, vector<bool>& is_lost,
+					 TransportRoutesData& routes_data) {
+
+	graph::IndexedHeap<double> heap(graph.GetVertexCount());
+
+	for (VertexId vertex : lost_vertices) {
+		for (const graph::EdgeId edge_id : incoming_edges[vertex]) {
+
+			const TransportEdge& edge = graph.GetEdge(edge_id);
+
+			if (is_lost[edge.from] || !routes_data.IsReachable(vertex_from, edge.from)) {
+				continue;
+			}
+			const double candidate_weight = routes_data.GetWeight(vertex_from, edge.from) + edge.weight;
+
+			if (!routes_data.IsReachable(vertex_from, vertex) || candidate_weight < routes_data.GetWeight(vertex_from, vertex)) {
+				routes_data.Set(vertex_from, vertex, candidate_weight, edge_id);
+				heap.PushOrDecrease(vertex, candidate_weight);
+			}
+		}
+	}
+
+	while (!heap.Empty()) {
+
+		const VertexId vertex = heap.PopMin();
+		const double vertex_weight = routes_data.GetWeight(vertex_from, vertex);
+
+		for (const auto& edge : frozen_graph.GetOutgoingEdges(vertex)) {
+
+			if (!is_lost[edge.to] || is_added_edge[edge.id]) {
+				continue;
+			}
+			const double candidate_weight = vertex_weight + edge.weight;
+
+			if (!routes_data.IsReachable(vertex_from, edge.to) || candidate_weight < routes_data.GetWeight(vertex_from, edge.to)) {
+				routes_data.Set(vertex_from, edge.to, candidate_weight, edge.id);
+				heap.PushOrDecrease(edge.to, candidate_weight);
+			}
+		}
+	}
+
+	for (VertexId vertex : lost_vertices) {
+		is_lost[vertex] = false;
+	}
+}
+
+// A route i -> j can only get shorter through the edge u -> v if both i -> u -> v is
+// shorter than i -> v and u -> v -> j is shorter than u -> j, so just those rows and
+// columns are crossed. Neither row v nor column u changes while the edge is inserted.
+void InsertRoutesEdge(const TransportGraph& graph, graph::EdgeId edge_id, TransportRoutesData& routes_data) {
+
+	const TransportEdge& edge = graph.GetEdge(edge_id);
+	const size_t vertex_count = graph.GetVertexCount();
+
+	vector<VertexId> vertices_from;
+	vector<VertexId> vertices_to;
+
+	for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+
+		if (routes_data.IsReachable(vertex, edge.from)
+			&& (!routes_data.IsReachable(vertex, edge.to)
+				|| routes_data.GetWeight(vertex, edge.from) + edge.weight < routes_data.GetWeight(vertex, edge.to))) {
+			vertices_from.push_back(vertex);
+		}
+		if (routes_data.IsReachable(edge.to, vertex)
+			&& (!routes_data.IsReachable(edge.from, vertex)
+				|| edge.weight + routes_data.GetWeight(edge.to, vertex) < routes_data.GetWeight(edge.from, vertex))) {
+			vertices_to.push_back(vertex);
+		}
+	}
+
+	for (VertexId vertex_from : vertices_from) {
+
+		const double weight_from = routes_data.GetWeight(vertex_from, edge.from) + edge.weight;
+
+		for (VertexId vertex_to : vertices_to) {
+
+			const double candidate_weight = weight_from + routes_data.GetWeight(edge.to, vertex_to);
+
+			if (!routes_data.IsReachable(vertex_from, vertex_to) || candidate_weight < routes_data.GetWeight(vertex_from, vertex_to)) {
+				routes_data.Set(vertex_from, vertex_to, candidate_weight, routes_data.GetPrevEdge(edge.to, vertex_to).value_or(edge_id));
+			}
+		}
+	}
+}
+
+TransportRoutesData UpdateRoutesData(const TransportGraph& graph, const TransportRoutesData& routes_data,
+									 const vector<optional<VertexId>>& vertex_ids, const vector<optional<graph::EdgeId>>& edge_ids) {
+
+	const size_t vertex_count = graph.GetVertexCount();
+	const size_t previous_vertex_count = routes_data.GetVertexCount();
+
+	if (vertex_ids.size() != previous_vertex_count) {
+		throw invalid_argument("Vertex ids do not match the routes table");
+	}
+
+	vector<bool> is_added_edge(graph.GetEdgeCount(), true);
+	vector<optional<VertexId>> previous_vertex_ids(vertex_count);
+
+	for (const optional<graph::EdgeId>& edge_id : edge_ids) {
+		if (edge_id) {
+			is_added_edge.at(*edge_id) = false;
+		}
+	}
+	for (VertexId previous_vertex = 0; previous_vertex < previous_vertex_count; ++previous_vertex) {
+		if (vertex_ids[previous_vertex]) {
+			previous_vertex_ids.at(*vertex_ids[previous_vertex]) = previous_vertex;
+		}
+	}
+
+	// Kept edges by their end vertex, to search lost cells from their kept neighbours
+	vector<vector<graph::EdgeId>> incoming_edges(vertex_count);
+
+	for (graph::EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+		if (!is_added_edge[edge_id]) {
+			incoming_edges[graph.GetEdge(edge_id).to].push_back(edge_id);
+		}
+	}
+	const graph::FrozenWeightedGraph<double> frozen_graph(graph);
+
+	TransportRoutesData updated_data(vertex_count);
+
+	for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+		updated_data.Set(vertex, vertex, 0., nullopt);
+	}
+
+	enum class CellState : uint8_t { UNKNOWN, KEPT, LOST };
+
+	vector<CellState> cell_states;
+	vector<VertexId> route_vertices;
+	vector<VertexId> lost_vertices;
+	vector<bool> is_lost(vertex_count, false);
+
+	for (VertexId previous_from = 0; previous_from < previous_vertex_count; ++previous_from) {
+
+		if (!vertex_ids[previous_from]) {
+			continue;
+		}
+		if (!routes_data.IsRowValid(previous_from)) {
+			throw invalid_argument("Routes table is corrupted");
+		}
+		const VertexId vertex_from = *vertex_ids[previous_from];
+		cell_states.assign(previous_vertex_count, CellState::UNKNOWN);
+
+		// A cell is lost if its route has a lost edge; the route is walked back until a known cell
+		for (VertexId previous_to = 0; previous_to < previous_vertex_count; ++previous_to) {
+
+			VertexId vertex = previous_to;
+			CellState state = cell_states[vertex];
+
+			while (state == CellState::UNKNOWN) {
+
+				const optional<graph::EdgeId> prev_edge = routes_data.GetPrevEdge(previous_from, vertex);
+
+				if (!prev_edge) {
+					state = CellState::KEPT;
+				}
+				else if (!edge_ids.at(*prev_edge)) {
+					state = CellState::LOST;
+				}
+				else {
+					route_vertices.push_back(vertex);
+					vertex = *previous_vertex_ids[graph.GetEdge(*edge_ids[*prev_edge]).from];
+					state = cell_states[vertex];
+					continue;
+				}
+				cell_states[vertex] = state;
+			}
+			for (VertexId route_vertex : route_vertices) {
+				cell_states[route_vertex] = state;
+			}
+			route_vertices.clear();
+		}
+
+		for (VertexId previous_to = 0; previous_to < previous_vertex_count; ++previous_to) {
+
+			if (!vertex_ids[previous_to]) {
+				continue;
+			}
+			if (cell_states[previous_to] == CellState::LOST) {
+				lost_vertices.push_back(*vertex_ids[previous_to]);
+				is_lost[*vertex_ids[previous_to]] = true;
+				continue;
+			}
+			if (!routes_data.IsReachable(previous_from, previous_to)) {
+				continue;
+			}
+			const optional<graph::EdgeId> prev_edge = routes_data.GetPrevEdge(previous_from, previous_to);
+
+			updated_data.Set(vertex_from, *vertex_ids[previous_to], routes_data.GetWeight(previous_from, previous_to),
+							 prev_edge ? edge_ids[*prev_edge] : nullopt);
+		}
+
+		if (!lost_vertices.empty()) {
+			RepairRoutesRow(graph, frozen_graph, incoming_edges, is_added_edge, vertex_from, lost_vertices, is_lost,
+							updated_data);
+			lost_vertices.clear();
+		}
+	}
+
+	for (graph::EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+		if (is_added_edge[edge_id]) {
+			InsertRoutesEdge(graph, edge_id, updated_data);
+		}
+	}
+	return updated_data;
+}
+
 } //namespace routing
\ No newline at end of file
@@ -1,106 +1,190 @@
-#pragma once
-
-#include "graph.h"
-#include "transport_catalogue.h"
-#include "router.h"
-
-#include <string_view>
-#include <exception>
-#include <vector>
-#include <memory>
-#include <optional>
-#include <numeric>
-
-namespace routing {
-
-struct Attrs {
-	double bus_velocity = 0; // kph
-	size_t bus_wait_time = 0; // minutes
-};
-
-struct EdgeInfo {
-	std::string_view bus_name;
-	int span_count;
-};
-
-using TransportEdge = graph::Edge<double>; // weight = minutes
-using TransportGraph = graph::DirectedWeightedGraph<double>;
-using RouteInfo = std::optional < graph::Router<double>::RouteInfo>;
-using graph::VertexId;
-using TransportRoutesData = graph::Router<double>::RoutesInternalData;
-
-class TransportRouter {
-public:
-	TransportRouter(const transport::TransportCatalogue& transport_catalogue, Attrs attrs);
-	TransportRouter(const transport::TransportCatalogue& transport_catalogue, Attrs attrs, TransportRoutesData&& routes_data);
-
-	RouteInfo BuildRoute(size_t vertex_id_from, size_t vertex_id_to) const;
-
-	VertexId GetVertexId(std::string_view stop_name) const;
-
-	VertexId GetEdgeVertexFrom(graph::EdgeId edge_id) const;
-	std::string_view GetVertexStopName(graph::EdgeId edge_id) const;
-
-	double GetEdgeWeight(graph::EdgeId edge_id) const;
-	const EdgeInfo& GetEdgeInfo(graph::EdgeId edge_id) const;
-
-	size_t GetWaitTime() const;
-
-	const TransportGraph& GetGraph() const;
-
-	const graph::Router<double>& GetRouter() const;
-
-private:
-	inline void RouterInit();
-
-	void MatchStopsWithVertexId();
-
-	template<typename ITERATOR>
-	void AddBusEdgesOneWay(std::string_view bus_name, ITERATOR begin_it, ITERATOR end_it);
-
-	void AddEdge(const TransportEdge& edge, const EdgeInfo& edge_info);
-
-	const transport::TransportCatalogue& transport_catalogue_;
-	routing::Attrs attrs_;
-	TransportGraph graph_;
-	std::unordered_map<std::string_view, size_t> stops_to_vertex_id_;
-	std::vector<std::string_view> vertex_id_to_stop_name_;
-	std::vector<EdgeInfo> edge_id_to_info_;
-	std::optional<graph::Router<double>> router_;
-};
-
-template<typename ITERATOR>
-void TransportRouter::AddBusEdgesOneWay(std::string_view bus_name, ITERATOR path_begin_it, ITERATOR path_end_it) {
-
-	std::vector<double> travel_times;
-
-	for (auto stop_it = path_begin_it; next(stop_it) != path_end_it; ++stop_it) {
-
-		TransportEdge edge;
-		edge.from = stops_to_vertex_id_.at(*stop_it);
-		edge.to = stops_to_vertex_id_.at(*next(stop_it));
-
-		size_t distance = transport_catalogue_.GetDistance(*stop_it, *next(stop_it));
-		double travel_time = (distance / (attrs_.bus_velocity / 3.6)) / 60;
-		edge.weight = travel_time + attrs_.bus_wait_time;
-
-		EdgeInfo edge_info;
-		edge_info.bus_name = bus_name;
-		edge_info.span_count = 1;
-
-		AddEdge(edge, edge_info);
-
-		auto copy_stop_it = stop_it;
-
-		for (auto it = travel_times.rbegin(); it != travel_times.rend(); ++it) {
-			edge.weight += *it;
-			edge.from = stops_to_vertex_id_.at(*--copy_stop_it);
-			++edge_info.span_count;
-			AddEdge(edge, edge_info);
-		}
-		travel_times.push_back(travel_time);
-	}
-	
-}
-
+#pragma once
+
+#include "graph.h"
+#include "transport_catalogue.h"
+#include "router.h"
+#include "dijkstra_router.h"
+#include "contraction_router.h"
+#include "route_cache.h"
+
+#include <string_view>
+#include <exception>
+#include <stdexcept>
+#include <iterator>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <numeric>
+
+namespace routing {
+
+enum class RouterMode {
+	PRECOMPUTED, // all-pairs table built by make_base
+	ON_DEMAND, // Dijkstra search per request
+	CONTRACTED // contraction hierarchy built by make_base, searched per request
+};
+
+// Vertex id == stop id for the stop vertices in both models
+enum class GraphModel {
+	SPANS, // an edge from every stop of a bus path to every later one, O(L^2) edges per bus
+	STOP_BUS // a ride vertex per stop of a bus path: boarding, ride and alighting edges, O(L) per bus
+};
+
+struct Attrs {
+	double bus_velocity = 0; // kph
+	size_t bus_wait_time = 0; // minutes
+	RouterMode router_mode = RouterMode::PRECOMPUTED;
+	GraphModel graph_model = GraphModel::SPANS;
+};
+
+struct EdgeInfo {
+	transport::BusId bus_id;
+	int span_count; // 0 - boarding or alighting edge of the stop-bus graph
+};
+
+// A Wait and a Bus item of a route
+struct RouteLeg {
+	transport::StopId stop_id; // where the bus is boarded
+	transport::BusId bus_id;
+	double ride_time; // minutes, without the wait
+	int span_count;
+};
+
+using TransportEdge = graph::Edge<double>; // weight = minutes
+using TransportGraph = graph::DirectedWeightedGraph<double>;
+using RouteInfo = std::optional < graph::Router<double>::RouteInfo>;
+using graph::VertexId;
+using TransportRoutesData = graph::Router<double>::RoutesInternalData;
+using TransportHierarchy = graph::ContractionRouter<double>::HierarchyInternalData;
+
+class TransportRouter {
+public:
+	TransportRouter(const transport::TransportCatalogue& transport_catalogue, Attrs attrs);
+	// Graph and edge records stored by make_base; the all-pairs table (the contraction
+	// hierarchy) is computed if routes_data (hierarchy) is not given and attrs.router_mode
+	// is PRECOMPUTED (CONTRACTED)
+	TransportRouter(const transport::TransportCatalogue& transport_catalogue, Attrs attrs, TransportGraph&& graph,
+					std::vector<EdgeInfo>&& edge_infos, std::optional<TransportRoutesData>&& routes_data,
+					std::optional<TransportHierarchy>&& hierarchy);
+
+	RouteInfo BuildRoute(size_t vertex_id_from, size_t vertex_id_to) const;
+
+	// A row of routes per vertex of from to every vertex of to. One search per row on demand,
+	// one per vertex of either list with the contraction hierarchy, table lookups when
+	// precomputed. Without with_edges the routes may hold no edges.
+	std::vector<std::vector<RouteInfo>> BuildRouteMatrix(const std::vector<VertexId>& from,
+														 const std::vector<VertexId>& to, bool with_edges) const;
+
+	// Route edges of either graph model as boarded buses
+	std::vector<RouteLeg> GetRouteLegs(const std::vector<graph::EdgeId>& edges) const;
+
+	VertexId GetVertexId(transport::StopId stop_id) const;
+
+	VertexId GetEdgeVertexFrom(graph::EdgeId edge_id) const;
+	transport::StopId GetVertexStop(VertexId vertex_id) const;
+
+	double GetEdgeWeight(graph::EdgeId edge_id) const;
+	const EdgeInfo& GetEdgeInfo(graph::EdgeId edge_id) const;
+
+	size_t GetWaitTime() const;
+
+	const TransportGraph& GetGraph() const;
+
+	const graph::Router<double>& GetRouter() const;
+	const graph::ContractionRouter<double>& GetContractionRouter() const;
+
+	// On demand, keeps the shortest path trees of recent route sources within memory_limit
+	// bytes, so routes from a source seen again take no search. No effect in other modes.
+	void EnableRouteCache(size_t memory_limit);
+	// nullopt if there is no route cache
+	std::optional<RouteCacheStats> GetRouteCacheStats() const;
+
+private:
+	inline void RouterInit();
+	void SearchInit(std::optional<TransportRoutesData>&& routes_data, std::optional<TransportHierarchy>&& hierarchy);
+
+	template<typename ITERATOR>
+	void AddBusEdgesOneWay(transport::BusId bus_id, ITERATOR begin_it, ITERATOR end_it);
+	template<typename ITERATOR>
+	void AddBusRideEdgesOneWay(transport::BusId bus_id, ITERATOR begin_it, ITERATOR end_it, VertexId& ride_vertex);
+
+	double GetTravelTime(transport::StopId stop_from, transport::StopId stop_to) const;
+
+	void AddEdge(const TransportEdge& edge, const EdgeInfo& edge_info);
+
+	// From the cache, or searched and cached
+	std::shared_ptr<const RouteTreeCache::Tree> GetRouteTree(VertexId vertex_id_from) const;
+
+	const transport::TransportCatalogue& transport_catalogue_;
+	routing::Attrs attrs_;
+	TransportGraph graph_; // stop vertices first, then the ride vertices of the stop-bus model
+	std::vector<EdgeInfo> edge_id_to_info_;
+	std::optional<graph::Router<double>> router_;
+	std::optional<graph::DijkstraRouter<double>> dijkstra_router_;
+	std::optional<graph::ContractionRouter<double>> contraction_router_;
+	std::unique_ptr<RouteTreeCache> route_cache_;
+};
+
+// All-pairs table of graph computed from the table of a previous version of it. vertex_ids and
+// edge_ids give the current id of every previous vertex and edge: nullopt for a removed vertex
+// and for a removed or changed edge. Only the cells whose route has such an edge are searched
+// again, without the added edges, which are then inserted one at a time, each relaxing only the
+// pairs it makes shorter. A small change costs far less than the Floyd-Warshall run of make_base.
+TransportRoutesData UpdateRoutesData(const TransportGraph& graph, const TransportRoutesData& routes_data,
+									 const std::vector<std::optional<VertexId>>& vertex_ids,
+									 const std::vector<std::optional<graph::EdgeId>>& edge_ids);
+
+template<typename ITERATOR>
+void TransportRouter::AddBusEdgesOneWay(transport::BusId bus_id, ITERATOR path_begin_it, ITERATOR path_end_it) {
+
+	std::vector<double> travel_times;
+
+	for (auto stop_it = path_begin_it; std::next(stop_it) != path_end_it; ++stop_it) {
+
+		TransportEdge edge;
+		edge.from = GetVertexId(*stop_it);
+		edge.to = GetVertexId(*std::next(stop_it));
+
+		double travel_time = GetTravelTime(*stop_it, *std::next(stop_it));
+		edge.weight = travel_time + attrs_.bus_wait_time;
+
+		EdgeInfo edge_info;
+		edge_info.bus_id = bus_id;
+		edge_info.span_count = 1;
+
+		AddEdge(edge, edge_info);
+
+		auto copy_stop_it = stop_it;
+
+		for (auto it = travel_times.rbegin(); it != travel_times.rend(); ++it) {
+			edge.weight += *it;
+			edge.from = GetVertexId(*--copy_stop_it);
+			++edge_info.span_count;
+			AddEdge(edge, edge_info);
+		}
+		travel_times.push_back(travel_time);
+	}
+	
+}
+
+// Ride vertices of the path are numbered from ride_vertex on, which is moved past them.
+// No bus is boarded at the last stop or left at the first one.
+template<typename ITERATOR>
+void TransportRouter::AddBusRideEdgesOneWay(transport::BusId bus_id, ITERATOR path_begin_it, ITERATOR path_end_it,
+											VertexId& ride_vertex) {
+
+	for (auto stop_it = path_begin_it; stop_it != path_end_it; ++stop_it, ++ride_vertex) {
+
+		const VertexId stop_vertex = GetVertexId(*stop_it);
+
+		if (stop_it != path_begin_it) {
+			AddEdge(TransportEdge{ ride_vertex, stop_vertex, 0. }, EdgeInfo{ bus_id, 0 });
+		}
+		if (std::next(stop_it) != path_end_it) {
+			AddEdge(TransportEdge{ stop_vertex, ride_vertex, static_cast<double>(attrs_.bus_wait_time) }, EdgeInfo{ bus_id, 0 });
+			AddEdge(TransportEdge{ ride_vertex, ride_vertex + 1, GetTravelTime(*stop_it, *std::next(stop_it)) }, EdgeInfo{ bus_id, 1 });
+		}
+	}
+}
+
 } // namespace routing
\ No newline at end of file